@@ -0,0 +1,52 @@
+/* Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+ 
+#include <iostream>
+#include <map>
+#include <string>
+#include "urp.hpp"
+
+int main()
+{
+  using namespace usingstdcpp2019::urp;
+
+  /* classify.cpp without a subgraph per initial */
+
+  trigger<std::string> s;
+  auto groups=s|aggregate_by(
+    [](const std::string& str){return str.c_str()[0];},
+    std::string{},
+    [](std::string acc,const std::string& str){return acc+str+" ";});
+  auto count=s|aggregate_by(
+    [](const std::string& str){return str.c_str()[0];},
+    0,[](int n,const std::string&){return n+1;});
+  auto num_groups=hold(count|delta_count());
+  auto num_names=hold(count|delta_sum());
+
+  std::map<char,std::string> res;
+  groups.connect([&](const auto&,const auto& c){res[c.key]=*c.new_value;});
+
+  auto names={
+    "John","Jack","Susan","Mary","Anne","Anthony","Bjarne","Margaret",
+    "George","Barack","Sarah","Peter","Hillary","Ronda","Alice","Herbert",
+  };
+  for(const auto& str:names)s=str;
+
+  for(const auto& [k,v]:res)std::cout<<v<<"\n";
+  std::cout<<num_names.get()<<" names in "<<num_groups.get()<<" groups\n";
+
+  /* single consumer: values come as rvalues, auto& callables still work */
+
+  trigger<std::string> u;
+  auto lengths=hold(u|aggregate_by(
+    [](auto& str){return str.size();},
+    0,[](int n,auto&){return n+1;}));
+  for(const auto& str:names)u=std::string{str};
+  std::cout<<"names of length "<<lengths.get().key<<": "
+           <<*lengths.get().new_value<<"\n";
+}
@@ -0,0 +1,60 @@
+/* Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+ 
+#define USINGSTDCPP2019_URP_FOOTPRINT_ALLOCATOR
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include "urp.hpp"
+#include "urp_footprint.hpp"
+
+struct trade
+{
+  int symbol;
+  int quantity;
+};
+
+int main(int argc,char** argv)
+{
+  using namespace usingstdcpp2019::urp;
+
+  std::size_t n=argc>1?std::strtoull(argv[1],nullptr,10):1000000,
+              keys=argc>2?std::strtoull(argv[2],nullptr,10):100000;
+  footprint   fp;
+  auto        symbol=[](const trade& t){return t.symbol;};
+  auto        add=[](int acc,const trade& t){return acc+t.quantity;};
+  auto        feed=[&](trigger<trade>& s){
+    auto t0=std::chrono::steady_clock::now();
+    for(std::size_t i=0;i<n;++i){
+      s=trade{int((i*7919)%keys),1};
+    }
+    return std::chrono::duration<double,std::nano>(
+      std::chrono::steady_clock::now()-t0).count()/n;
+  };
+
+  /* per-key state is created while feeding, so that's what gets charged */
+
+  trigger<trade> s1,s2;
+  int            last1=0,last2=0;
+  auto           e1=s1|group_by(symbol)|map([&](auto e){
+    return hold(std::move(e)|accumulate(0,add));
+  })|collect();
+  auto           e2=s2|aggregate_by(symbol,0,add);
+  e1.connect([&](const auto&,const auto& v){last1=v.back().get();});
+  e2.connect([&](const auto&,const auto& c){last2=*c.new_value;});
+
+  double t1=fp.track("group_by subgraphs",[&]{feed(s1);return feed(s1);});
+  double t2=fp.track("aggregate_by",[&]{feed(s2);return feed(s2);});
+  auto   bytes_per_key=[&](std::size_t i){
+    return double(fp.entries()[i].heap_bytes)/keys;};
+
+  std::cout<<"group_by subgraphs: "<<t1<<" ns/event, "
+           <<bytes_per_key(0)<<" heap bytes/key\n"
+           <<"aggregate_by:       "<<t2<<" ns/event, "
+           <<bytes_per_key(1)<<" heap bytes/key\n";
+}
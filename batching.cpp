@@ -0,0 +1,60 @@
+/* Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+ 
+#include <iostream>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+#include "urp.hpp"
+
+int main()
+{
+  using namespace usingstdcpp2019::urp;
+
+  auto print=[](const auto&,const std::vector<int>& v){
+    std::cout<<"[";
+    for(auto x:v)std::cout<<" "<<x;
+    std::cout<<" ] ";
+  };
+
+  {
+    trigger<int> s1,s2;
+    auto         b=merge_batched(3,s1,s2);
+    b.connect(print);
+    for(int i=0;i<7;++i)(i%2?s1:s2)=i; /* 6 stays pending */
+    std::cout<<"\n";
+  }
+  {
+    trigger<int>  s1,s2;
+    trigger<bool> commit;
+    auto          b=merge_batched_until(commit,3,s1,s2);
+    b.connect(print);
+    s1=10;s2=11;commit=true;       /* transaction of 2 */
+    s1=12;s2=13;s1=14;s2=15;       /* 4 events, one full batch */
+    commit=true;
+    commit=true;                   /* nothing pending */
+    std::cout<<"\n";
+  }
+  {
+    trigger<int> s1,s2;
+    auto         l=combine_latest(s1,s2);
+    l.connect([](const auto&,const std::tuple<int,int>& x){
+      std::cout<<"("<<std::get<0>(x)<<","<<std::get<1>(x)<<") ";
+    });
+    s1=1;s1=2;s2=3;s1=4;s2=5;
+    std::cout<<"\n";
+  }
+  {
+    trigger<int> s;
+    try{
+      merge_batched(0,s);
+      return 1;
+    }
+    catch(const std::invalid_argument&){} /* empty batches are rejected */
+  }
+}
@@ -0,0 +1,24 @@
+/* Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+ 
+#include <vector>
+#include "urp.hpp"
+
+int main()
+{
+  using namespace usingstdcpp2019::urp;
+
+  /* collect's state goes downstream as const: this must not compile */
+
+  trigger<int> s;
+  auto e=s|collect()|map([](std::vector<int>& v){
+    v.push_back(100);
+    return v.size();
+  });
+  s=1;
+}
@@ -0,0 +1,47 @@
+/* Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+ 
+/* Compile time benchmark: twelve-stage event and function pipelines, built
+ * stage by stage with operator| or, with FLAT_STAGES defined, as single
+ * nodes with stages() and chain(). Time the compile_bench_nested and
+ * compile_bench_flat targets and compare their object sizes.
+ */
+
+#include <functional>
+#include "urp.hpp"
+
+int main()
+{
+  using namespace usingstdcpp2019::urp;
+
+  auto even=filter([](int x){return x%2==0;});
+  auto f=[](int x){return x+1;};
+  auto sum=accumulate(0,std::plus<>{});
+
+  trigger<int> s;
+  value        x=0;
+
+#if defined(FLAT_STAGES)
+  auto e=s|stages(
+    even,map(f),map(f),map(f),map(f),map(f),map(f),
+    map(f),map(f),map(f),map(f),map(f),map(f),sum);
+  auto z=x|chain(f,f,f,f,f,f,f,f,f,f,f,f);
+#else
+  auto e=s|even|map(f)|map(f)|map(f)|map(f)|map(f)|map(f)
+          |map(f)|map(f)|map(f)|map(f)|map(f)|map(f)|sum;
+  auto z=x|f|f|f|f|f|f|f|f|f|f|f|f;
+#endif
+
+  int res=0;
+  e.connect([&](const auto&,int y){res=y;});
+  z.connect([](const auto&){});
+
+  s=2;
+  x=1;
+  return res==14&&z.get()==13?0:1;
+}
@@ -0,0 +1,46 @@
+/* Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+ 
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include "urp.hpp"
+
+int main()
+{
+  using namespace usingstdcpp2019::urp;
+
+  trigger<std::string> s;
+  auto                 u=s|distinct_until_changed();
+  auto                 d=s|distinct(3);
+  auto print=[](const char* name){
+    return [=](const auto&,const std::string& x){
+      std::cout<<name<<x<<"\n";
+    };
+  };
+  u.connect(print("until changed: "));
+  d.connect(print("distinct(3):   "));
+  for(auto str:{"a","a","b","a","c","d","a"})s=str;
+
+  /* ids repeat within a window of 1000: constant memory dedup */
+
+  trigger<long> ids;
+  int           exact=0,approx=0;
+  auto          e=ids|distinct(1000);
+  auto          a=ids|distinct_approx(1000,0.01);
+  e.connect([&](const auto&,long){++exact;});
+  a.connect([&](const auto&,long){++approx;});
+  for(long i=0;i<100000;++i)ids=i/2+(i%2)*500; /* each id twice */
+  std::cout<<"exact: "<<exact<<" unique, approx: "<<approx<<" unique\n";
+
+  try{
+    distinct_approx(1000,0.0);
+    return 1;
+  }
+  catch(const std::invalid_argument&){} /* fp_rate out of (0,1) is rejected */
+}
@@ -0,0 +1,47 @@
+/* Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+ 
+#include <iostream>
+#include "urp.hpp"
+
+int main()
+{
+  using namespace usingstdcpp2019::urp;
+
+  int   calls=0;
+  auto  f=[&](int x){++calls;return x+1;};
+  value x=0;
+  auto  y=x|f;
+  auto  w=y|f;
+  auto  z=w|f;
+
+  /* nobody observes z: the chain goes dormant after the first update */
+  for(int i=1;i<=1000;++i)x=i;
+  std::cout<<"dormant:   "<<calls<<" calls, z="<<z.get()<<"\n";
+
+  calls=0;
+  auto c=z.connect([](const auto&){});
+  for(int i=1;i<=1000;++i)x=i;
+  std::cout<<"observed:  "<<calls<<" calls, z="<<z.get()<<"\n";
+
+  calls=0;
+  c.disconnect();
+  for(int i=1;i<=1000;++i)x=i;
+  std::cout<<"dormant:   "<<calls<<" calls, z="<<z.get()<<"\n";
+
+  /* read after every update: z is kept live rather than resumed each time */
+  calls=0;
+  const auto& cz=z;
+  int         sum=0;
+  for(int i=1;i<=1000;++i){
+    x=i;
+    sum+=cz.get();
+  }
+  std::cout<<"pulled:    "<<calls<<" calls, sum="<<sum<<"\n";
+  return calls==3000?0:1;
+}
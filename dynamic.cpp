@@ -0,0 +1,75 @@
+/* Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+ 
+#include <iostream>
+#include <string>
+#include <vector>
+#include "urp_dynamic.hpp"
+
+int main()
+{
+  using namespace usingstdcpp2019::urp::dynamic;
+
+  registry reg;
+  reg.define_function("add",[](const arguments& args){
+    return any_value{args.get<double>(0)+args.get<double>(1)};
+  });
+  reg.define_function("half",[](const arguments& args){
+    return any_value{args.get<double>(0)/2};
+  });
+  reg.define_reaction("positive",
+    [](const emitter& e,std::size_t,const any_value& x){
+      if(x.get<double>()>0)e(x);
+  });
+  reg.define_reaction("sum",
+    [s=0.0](const emitter& e,std::size_t,const any_value& x)mutable{
+      e(s+=x.get<double>());
+  });
+
+  /* what a configuration file would describe */
+
+  struct rule{std::string kind,name,op;std::vector<std::string> args;};
+  std::vector<rule> rules={
+    {"value",   "x",      "",        {}},
+    {"value",   "y",      "",        {}},
+    {"function","x+y",    "add",     {"x","y"}},
+    {"function","(x+y)/2","half",    {"x+y"}},
+    {"trigger", "fills",  "",        {}},
+    {"event",   "buys",   "positive",{"fills"}},
+    {"event",   "bought", "sum",     {"buys"}}
+  };
+
+  graph g{reg};
+  for(const auto& r:rules){
+    std::vector<node_id> args;
+    for(const auto& name:r.args)args.push_back(g.find(name));
+    if(r.kind=="value")       g.add_value(r.name,0.0);
+    else if(r.kind=="trigger")g.add_trigger(r.name);
+    else if(r.kind=="function"){
+      g.add_function(r.name,reg.function(r.op),args);
+    }
+    else g.add_event(r.name,reg.reaction(r.op),args);
+  }
+  g.add_hold("total",g.find("bought"),0.0);
+  g.add_function("mark",[](const arguments& args){
+    return any_value{args.get<double>(0)*args.get<double>(1)};
+  },{g.find("total"),g.find("(x+y)/2")});
+
+  g.add_function("one",[](const arguments&){return any_value{1.0};},{});
+  std::cout<<"one="<<g.get<double>(g.find("one"))<<"\n";
+
+  g.connect(g.find("(x+y)/2"),[](const any_value& x){
+    std::cout<<"(x+y)/2="<<x.get<double>()<<"\n";
+  });
+
+  g.set(g.find("x"),4.0);
+  g.set(g.find("y"),6.0);
+  for(double q:{10.0,-5.0,2.5})g.fire(g.find("fills"),q);
+  std::cout<<"total="<<g.get<double>(g.find("total"))<<"\n"
+           <<"mark="<<g.get<double>(g.find("mark"))<<"\n";
+}
@@ -0,0 +1,93 @@
+/* Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+ 
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include "urp.hpp"
+#include "urp_dynamic.hpp"
+#include "urp_static.hpp"
+
+template<typename F>
+void measure(const char* name,std::size_t n,F f)
+{
+  auto t0=std::chrono::steady_clock::now();
+  auto res=f();
+  auto t=std::chrono::duration<double,std::nano>(
+    std::chrono::steady_clock::now()-t0).count();
+  std::cout<<name<<": "<<t/n<<" ns/update (result "<<res<<")\n";
+}
+
+int main(int argc,char** argv)
+{
+  std::size_t n=argc>1?std::strtoull(argv[1],nullptr,10):1000000;
+
+  auto f=[](int x){return x+1;};
+  auto g=[](int x){return 2*x;};
+  auto h=[](int x){return x*(x+1);};
+
+  measure("templated, one node per stage",n,[&]{
+    using namespace usingstdcpp2019::urp;
+    value x=0;
+    auto  y=x|f;
+    auto  w=y|g;
+    auto  z=w|h;
+    long  res=0;
+    for(std::size_t i=0;i<n;++i){
+      x=int(i%1000);
+      res+=z.get();
+    }
+    return res;
+  });
+
+  measure("templated, fused x|f|g|h",n,[&]{
+    using namespace usingstdcpp2019::urp;
+    value x=0;
+    auto  z=x|f|g|h;
+    long  res=0;
+    for(std::size_t i=0;i<n;++i){
+      x=int(i%1000);
+      res+=z.get();
+    }
+    return res;
+  });
+
+  measure("static graph, one node per stage",n,[&]{
+    using namespace usingstdcpp2019::urp;
+    static_graph gr{
+      static_value<struct x>(0),
+      static_function<struct y,x>(f),
+      static_function<struct w,y>(g),
+      static_function<struct z,w>(h)
+    };
+    long res=0;
+    for(std::size_t i=0;i<n;++i){
+      gr.set<x>(int(i%1000));
+      res+=gr.get<z>();
+    }
+    return res;
+  });
+
+  measure("dynamic, one node per stage",n,[&]{
+    using namespace usingstdcpp2019::urp::dynamic;
+    auto lift=[](auto f){
+      return [=](const arguments& args){return any_value{f(args.get<int>(0))};};
+    };
+    graph gr;
+    auto  x=gr.add_value("x",0);
+    auto  y=gr.add_function("y",lift(f),{x});
+    auto  w=gr.add_function("w",lift(g),{y});
+    auto  z=gr.add_function("z",lift(h),{w});
+    long  res=0;
+    for(std::size_t i=0;i<n;++i){
+      gr.set(x,int(i%1000));
+      res+=gr.get<int>(z);
+    }
+    return res;
+  });
+}
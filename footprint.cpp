@@ -0,0 +1,55 @@
+/* Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+ 
+#define USINGSTDCPP2019_URP_FOOTPRINT_ALLOCATOR
+#include <iostream>
+#include "urp.hpp"
+#include "urp_footprint.hpp"
+#include "urp_static.hpp"
+
+int main()
+{
+  using namespace usingstdcpp2019::urp;
+
+  footprint fp;
+  auto      f=[](int x){return x+1;};
+
+  /* nodes are kept alive so that their heap blocks stay charged; figures
+   * cover only what's built inside each track() call, and this program
+   * runs no other threads that could get their allocations mixed in
+   */
+
+  auto x=fp.track("value<int>",[]{return value<int>{0};});
+  auto y=fp.track("function, one source",[&]{return x|f;});
+  auto z=fp.track("function, two sources",[&]{
+    return function{[](int x,int y){return x+y;},x,y};});
+  fp.track("connection to function",[&]{z.connect([](const auto&){});});
+  auto s=fp.track("trigger<int>",[]{return trigger<int>{};});
+  auto e=fp.track("event, map",[&]{
+    return s|map([](int x){return 2*x;});});
+  auto a=fp.track("event, accumulate",[&]{
+    return s|accumulate(0,std::plus<>{});});
+  auto h=fp.track("hold",[&]{return hold(std::move(a));});
+  auto m=fp.track("function, memoized",[&]{return x|memoize(f,1024);});
+  m.connect([](const auto&){});
+  fp.track("memoize cache, 1000 entries",[&]{for(int i=0;i<1000;++i)x=i;});
+  fp.track("static_graph, 3 nodes",[&]{
+    return static_graph{
+      static_value<struct sx>(0),
+      static_function<struct sy,sx>(f),
+      static_function<struct sz,sx,sy>([](int x,int y){return x+y;})};
+  });
+
+  /* over-aligned and array allocations are counted as well */
+
+  struct alignas(64) line{char c[64];};
+  line* volatile lines=fp.track("over-aligned new[]",[]{return new line[4];});
+  std::cout<<fp;
+  delete[] lines; /* kept alive past track() so it can't be optimized out */
+  return fp.entries().back().allocations==1?0:1;
+}
@@ -0,0 +1,42 @@
+/* Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+ 
+#include <iostream>
+#include <string>
+#include "urp.hpp"
+
+int main()
+{
+  using namespace usingstdcpp2019::urp;
+
+  vector_value<int> v;
+  auto total=hold(v|delta_sum());
+  auto large=hold(v|delta_filter([](int x){return x>=10;})|delta_count());
+
+  map_value<std::string,int> positions;
+  auto exposure=hold(
+    positions|delta_map([](int x){return x<0?-x:x;})|delta_sum());
+  
+  auto print=[&]{
+    std::cout<<"total="<<total.get()<<" large="<<large.get()
+             <<" exposure="<<exposure.get()<<"\n";
+  };
+
+  for(int x:{3,14,15,9,26})v.push_back(x);
+  print();
+  v.set(0,30);
+  v.erase(1);
+  print();
+  
+  positions.insert_or_assign("ACME",100);
+  positions.insert_or_assign("INITECH",-50);
+  positions.insert_or_assign("ACME",-20);
+  print();
+  positions.erase("INITECH");
+  print();
+}
@@ -0,0 +1,51 @@
+/* Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+ 
+#include <iostream>
+#include <string>
+#include "urp.hpp"
+
+struct order
+{
+  int         id;
+  std::string symbol;
+};
+
+struct fill
+{
+  int    id;
+  double price;
+};
+
+int main()
+{
+  using namespace usingstdcpp2019::urp;
+
+  trigger<order> orders;
+  trigger<fill>  fills;
+  auto           id=[](const auto& x){return x.id;};
+  auto           e=join_by(id,orders,fills);
+  auto           e1=join_by(id,join_window{1},orders,fills);
+    
+  e.connect([](const auto&,const auto& t){
+    auto& [o,f]=t;
+    std::cout<<"e : "<<o.symbol<<" #"<<o.id<<" filled at "<<f.price<<"\n";
+  });
+  e1.connect([](const auto&,const auto& t){
+    auto& [o,f]=t;
+    std::cout<<"e1: "<<o.symbol<<" #"<<o.id<<" filled at "<<f.price<<"\n";
+  });
+  
+  orders=order{1,"ACME"};
+  orders=order{2,"INITECH"};
+  fills=fill{1,10.5};
+  fills=fill{2,20.0};
+  fills=fill{1,10.75};
+  orders=order{3,"UMBRELLA"};
+  fills=fill{3,5.25};
+}
@@ -0,0 +1,77 @@
+/* Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+ 
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "urp.hpp"
+#include "urp_file.hpp"
+
+int main()
+{
+  using namespace usingstdcpp2019::urp;
+
+  struct temp_file /* removed on every way out of main */
+  {
+    ~temp_file(){std::filesystem::remove(path);}
+
+    std::string path;
+  } tmp{(std::filesystem::temp_directory_path()/"urp_lines.txt").string()};
+
+  const auto& path=tmp.path;
+  {
+    std::ofstream os{path};
+    os<<"John\nJack\nSusan\nMary\nAnne\nAnthony\nBjarne\nMargaret\n"
+        "George\nBarack\nSarah\nPeter\nHillary\nRonda\nAlice\nHerbert";
+  }
+
+  /* classify.cpp over views into the mapped file */
+
+  {
+    line_reader               lines{path};
+    trigger<std::string_view> s;
+    auto res=hold(
+      s|group_by([](std::string_view str){return str.empty()?'\0':str[0];})
+       |map([](auto e){
+         return hold(std::move(e)|collect());
+       })
+       |collect()
+    );
+    lines.replay(s);
+
+    for(const auto& e:res.get()){
+      for(const auto& str:e.get())std::cout<<str<<" ";
+      std::cout<<"\n";
+    }
+  }
+
+  /* batched dispatch: one propagation per 5 lines */
+
+  {
+    line_reader                            lines{path};
+    trigger<std::vector<std::string_view>> s;
+    auto sizes=s|map([](const std::vector<std::string_view>& v){
+      return v.size();
+    });
+    sizes.connect([](const auto&,std::size_t n){std::cout<<n<<" ";});
+    std::cout<<"batches: ";
+    lines.replay(s,5);
+    std::cout<<"\n";
+
+    lines.rewind();
+    try{
+      lines.replay(s,0);
+      return 1;
+    }
+    catch(const std::invalid_argument&){}
+  }
+}
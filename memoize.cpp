@@ -0,0 +1,37 @@
+/* Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+ 
+#include <cmath>
+#include <iostream>
+#include "urp.hpp"
+
+int main()
+{
+  using namespace usingstdcpp2019::urp;
+
+  int  calls=0;
+  auto pricing=memoize([&](int regime,int bucket){
+    ++calls;
+    double res=0.0;
+    for(int i=1;i<=100000;++i)res+=std::sin(regime*bucket+i)/i;
+    return res;
+  },8);
+
+  value    regime=0,bucket=0;
+  function price={pricing,regime,bucket};
+  double   total=0.0;
+
+  for(int i=0;i<100;++i){
+    regime=i%2;
+    bucket=(i/4)%3;
+    total+=price.get();
+  }
+  std::cout<<"price="<<price.get()<<" total="<<total<<"\n"
+           <<"calls="<<calls<<" hits="<<pricing.hits()
+           <<" misses="<<pricing.misses()<<"\n";
+}
@@ -0,0 +1,80 @@
+/* Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+ 
+#include <iostream>
+#include <string>
+#include "urp.hpp"
+#include "urp_scheduler.hpp"
+
+struct message
+{
+  message()=default;
+  message(const char* str):str{str}{}
+  message(const message& x):str{x.str}{++copies;}
+  message(message&&)=default;
+  message& operator=(const message& x){str=x.str;++copies;return *this;}
+  message& operator=(message&&)=default;
+
+  inline static int copies=0;
+  std::string       str;
+};
+
+int main()
+{
+  using namespace usingstdcpp2019::urp;
+
+  trigger<message> s;
+  auto res=hold(
+    s|filter([](const message& m){return !m.str.empty();})
+     |map([](message m){m.str+="!";return m;})
+  );
+
+  message::copies=0;
+  s=message{"a message buffer large enough to live on the heap"};
+  std::cout<<res.get().str<<"\n"
+           <<"single consumer: "<<message::copies<<" copies\n";
+  int single_copies=message::copies;
+    
+  auto res2=hold(s|map([](const message& m){return m;}));
+  message::copies=0;
+  s=message{"another message buffer large enough to live on the heap"};
+  std::cout<<res2.get().str<<"\n"
+           <<"fan-out: "<<message::copies<<" copies\n";
+  int fan_out_copies=message::copies;
+
+  /* callables taking lvalue references still get the payload */
+
+  trigger<std::string> t,u;
+  auto                 len=hold(
+    t|filter([](auto& str){return !str.empty();})
+     |map([](auto& str){return str.size();}));
+  auto                 total=hold(
+    u|accumulate(std::size_t(0),[](std::size_t n,auto& str){
+      return n+str.size();}));
+  for(auto str:{"abc","","de"}){
+    t=std::string{str};
+    u=std::string{str};
+  }
+  std::cout<<"last length: "<<len.get()<<", total: "<<total.get()<<"\n";
+
+  /* a deferred edge copies its payload once, into the posted task */
+
+  scheduler        sch{1};
+  trigger<message> src,dst;
+  deferred         d{sch,0,src,dst};
+  auto             last=hold(dst|map([](const message& m){return m.str;}));
+  message::copies=0;
+  src=message{"a deferred message buffer large enough to live on the heap"};
+  sch.run();
+  std::cout<<last.get()<<"\n"
+           <<"deferred edge: "<<message::copies<<" copies\n";
+  int deferred_copies=message::copies;
+
+  return single_copies==0&&fan_out_copies>0&&deferred_copies==1&&
+    len.get()==2&&total.get()==5?0:1;
+}
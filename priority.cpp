@@ -0,0 +1,59 @@
+/* Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+ 
+#include <chrono>
+#include <iostream>
+#include "urp.hpp"
+#include "urp_scheduler.hpp"
+
+int main()
+{
+  using namespace usingstdcpp2019::urp;
+
+  auto busy=[](int x){ /* some 10us of work per stage */
+    auto t=std::chrono::steady_clock::now()+std::chrono::microseconds(10);
+    while(std::chrono::steady_clock::now()<t);
+    return x;
+  };
+
+  /* a backfill cascade, split in two tasks by a deferred edge, competes
+   * with risk limit updates: with one lane these queue behind the growing
+   * backfill backlog, with two they overtake it
+   */
+
+  double p99[2];
+  for(std::size_t risk_lane:{1,0}){
+    scheduler     sch{2};
+    trigger<int>  backfill,stage2;
+    trigger<int>  limit;
+    auto          a=backfill|map(busy);
+    deferred      d{sch,1,a,stage2};
+    int           total=0,breaches=0;
+    auto          b=stage2|map(busy)|accumulate(0,std::plus<>{});
+    auto          r=limit|filter([](int x){return x>=80;});
+    b.connect([&](const auto&,int x){total=x;});
+    r.connect([&](const auto&,int){++breaches;});
+
+    for(int i=0;i<2000;++i){
+      sch.post(1,[&,i]{backfill=i;});
+      if(i%20==0)sch.post(risk_lane,[&,i]{limit=i%100;});
+      sch.run_one();
+    }
+    sch.run();
+
+    auto s=sch.stats(risk_lane);
+    p99[risk_lane?0:1]=s.p99;
+    std::cout<<(risk_lane?"one lane: ":"two lanes:")
+             <<" backfill total="<<total<<", breaches="<<breaches
+             <<", risk lane p99 "<<s.p99/1000<<" us\n";
+  }
+
+  /* a lane of its own must cut the risk p99 at least tenfold */
+
+  return p99[1]<p99[0]/10?0:1;
+}
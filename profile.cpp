@@ -0,0 +1,56 @@
+/* Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+ 
+#include <cmath>
+#include <iostream>
+#include "urp.hpp"
+#include "urp_profile.hpp"
+
+int main()
+{
+  using namespace usingstdcpp2019::urp;
+
+  /* x/2+882/x with a costly refinement on one of the branches */
+
+  auto refine=[](double x){
+    for(int i=0;i<2000;++i)x=std::sqrt(x*x+1e-9);
+    return x;
+  };
+
+  value x=1.0;
+  auto  half=x/2;
+  auto  inv=882/x;
+  auto  fine=inv|refine;
+  auto  y=half+fine;
+  y.connect([](const auto&){});
+
+  profiler::label(x,"x");
+  profiler::label(half,"x/2");
+  profiler::label(inv,"882/x");
+  profiler::label(fine,"refine(882/x)");
+  profiler::label(y,"y");
+
+  profiler::enable();
+  for(int i=1;i<=100;++i)x=double(i);
+  profiler::disable();
+  x=0.5; /* not recorded */
+
+  std::cout<<"y="<<y.get()<<"\ncritical path:\n";
+  auto path=profiler::critical_path();
+  for(const auto& s:path){
+    std::cout<<"  "<<s.node<<": "<<s.calls<<" calls, "<<s.ns/1000<<" us\n";
+  }
+
+  std::cout<<"\nfolded stacks:\n";
+  profiler::write_folded(std::cout);
+
+  std::cout<<"\n";
+  profiler::write_dot(std::cout);
+
+  return path.size()==4&&path[2].node=="refine(882/x)"?0:1;
+}
@@ -0,0 +1,61 @@
+/* Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+ 
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include "urp.hpp"
+
+struct score
+{
+  std::string player;
+  int         points;
+};
+
+int main()
+{
+  using namespace usingstdcpp2019::urp;
+
+  trigger<score> scores;
+  auto leaders=scores|top_k(3,[](const score& x,const score& y){
+    return x.points>y.points;});
+  leaders.connect([](const auto&,const auto& v){
+    std::cout<<"leaders:";
+    for(const auto& s:v)std::cout<<" "<<s.player<<"("<<s.points<<")";
+    std::cout<<"\n";
+  });
+
+  for(auto s:{
+    score{"John",10},score{"Mary",30},score{"Anne",20},score{"Peter",5},
+    score{"Susan",25},score{"Alice",1},score{"Bjarne",40}
+  })scores=s;
+
+  trigger<int> latency;
+  auto         p50=hold(latency|quantile(0.5));
+  auto         p99=latency|quantile(0.99);
+  double       last_p99=0.0;
+  int          changes=0;
+  p99.connect([&](const auto&,double x){last_p99=x;++changes;});
+
+  /* exact values: p50 599.5, p99 1089 */
+
+  for(int i=0;i<100000;++i)latency=100+(i*7919)%1000;
+  std::cout<<"latency p50 ~"<<p50.get()<<", p99 ~"<<last_p99
+           <<" ("<<changes<<" p99 changes in 100000 samples)\n";
+
+  try{
+    quantile(1.5);
+    return 1;
+  }
+  catch(const std::invalid_argument&){} /* q out of [0,1] is rejected */
+  try{
+    quantile(0.5,0.0);
+    return 1;
+  }
+  catch(const std::invalid_argument&){} /* and so is rel_err out of (0,1) */
+}
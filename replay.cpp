@@ -0,0 +1,70 @@
+/* Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+ 
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include "urp.hpp"
+#include "urp_file.hpp"
+
+struct tick
+{
+  int    symbol;
+  double price;
+};
+
+struct fill /* not default constructible */
+{
+  fill(int qty):qty{qty}{}
+
+  int qty;
+};
+
+int main()
+{
+  using namespace usingstdcpp2019::urp;
+
+  auto path=(std::filesystem::temp_directory_path()/"urp_replay.bin").string();
+
+  {
+    trigger<tick> s;
+    recorder      rec{s,path};
+    for(int i=0;i<10;++i)s=tick{i%3,100.0+i};
+  }
+
+  trigger<tick> s;
+  auto e=s|filter([](const tick& t){return t.symbol==0;})
+          |map([](const tick& t){return t.price;})
+          |accumulate(0.0,std::plus<>{});
+  e.connect([](const auto&,double x){std::cout<<x<<" ";});
+
+  replayer<tick> rep{path};
+  while(!rep.done()){
+    auto m=rep.replay(s,4);
+    std::cout<<"("<<m<<" records) ";
+  }
+  std::cout<<"\n";
+  std::filesystem::remove(path);
+
+  {
+    trigger<fill> f;
+    recorder      rec{f,path};
+    for(int i=1;i<=4;++i)f=fill{i};
+  }
+
+  trigger<fill> f;
+  int           total=0;
+  auto          c=f.connect([&](const auto&,const fill& x){total+=x.qty;});
+  replayer<fill>{path}.replay(f);
+  std::cout<<"total qty: "<<total<<"\n";
+
+  std::ofstream{path,std::ios::trunc}; /* an empty file replays nothing */
+  replayer<fill> empty{path};
+  std::filesystem::remove(path);
+  return total==10&&empty.size()==0&&empty.replay(f)==0?0:1;
+}
@@ -0,0 +1,70 @@
+/* Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+ 
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include "urp.hpp"
+#include "urp_file.hpp"
+
+struct tick
+{
+  std::int64_t timestamp;
+  std::int32_t symbol;
+  std::int32_t quantity;
+  double       price;
+};
+
+template<typename F>
+double seconds(F f)
+{
+  auto t0=std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now()-t0)
+    .count();
+}
+
+int main(int argc,char** argv)
+{
+  using namespace usingstdcpp2019::urp;
+
+  std::size_t n=argc>1?std::strtoull(argv[1],nullptr,10):10000000;
+  auto        path=
+    (std::filesystem::temp_directory_path()/"urp_replay_bench.bin").string();
+  auto        report=[&](const char* name,double t){
+    std::cout<<name<<": "<<n/t/1e6<<" Mrecords/s, "
+             <<n*sizeof(tick)/t/(1<<20)<<" MB/s\n";
+  };
+
+  report("record",seconds([&]{
+    trigger<tick> s;
+    recorder      rec{s,path};
+    for(std::size_t i=0;i<n;++i){
+      s=tick{std::int64_t(i),std::int32_t(i%64),1,100.0+i%10};
+    }
+  }));
+
+  trigger<tick> s;
+  double        volume=0.0;
+  s.connect([&](const auto&,const tick& t){volume+=t.quantity*t.price;});
+
+  report("assignment loop",seconds([&]{
+    for(std::size_t i=0;i<n;++i){
+      s=tick{std::int64_t(i),std::int32_t(i%64),1,100.0+i%10};
+    }
+  }));
+  for(std::size_t batch:{std::size_t(1),std::size_t(64),std::size_t(4096)}){
+    replayer<tick> rep{path};
+    std::cout<<"batch "<<batch<<", ";
+    report("replay",seconds([&]{while(rep.replay(s,batch));}));
+  }
+  std::cout<<"(checksum "<<volume<<")\n";
+  std::filesystem::remove(path);
+}
@@ -0,0 +1,68 @@
+/* Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+ 
+#include <iostream>
+#include <memory>
+#include "urp.hpp"
+#include "urp_shard.hpp"
+
+struct tick
+{
+  int symbol;
+  int volume;
+};
+
+int main()
+{
+  using namespace usingstdcpp2019::urp;
+
+  auto volume=[](const tick& t){return t.volume;};
+  auto even=[](const tick& t){return t.symbol%2==0;};
+  auto odd=[](const tick& t){return t.symbol%2!=0;};
+
+  /* nodes are built, used and destroyed on the shard owning them */
+
+  auto make_on=[](shard& sh,auto build){
+    return sh.execute([&]{
+      return std::make_unique<decltype(build())>(build());});
+  };
+  auto destroy_on=[](shard& sh,auto& p){sh.execute([&]{p.reset();});};
+
+  /* feed shard partitions ticks by symbol, each worker sums its half */
+
+  shard feed,worker0,worker1;
+  auto  ticks=make_on(feed,[]{return trigger<tick>{};});
+  auto  part0=make_on(feed,[&]{return *ticks|filter(even);});
+  auto  part1=make_on(feed,[&]{return *ticks|filter(odd);});
+  auto  in0=make_on(worker0,[]{return trigger<tick>{};});
+  auto  total0=make_on(worker0,[&]{
+    return hold(*in0|map(volume)|accumulate(0,std::plus<>{}));});
+  auto  in1=make_on(worker1,[]{return trigger<tick>{};});
+  auto  total1=make_on(worker1,[&]{
+    return hold(*in1|map(volume)|accumulate(0,std::plus<>{}));});
+
+  {
+    channel edge0{feed,*part0,worker0,*in0},edge1{feed,*part1,worker1,*in1};
+
+    feed.execute([&]{
+      for(int i=0;i<100000;++i)*ticks=tick{i%8,i%10};
+    });
+    std::cout<<"even symbols: "
+             <<worker0.execute([&]{return total0->get();})<<"\n";
+    std::cout<<"odd symbols:  "
+             <<worker1.execute([&]{return total1->get();})<<"\n";
+  }
+
+  destroy_on(worker1,total1);
+  destroy_on(worker1,in1);
+  destroy_on(worker0,total0);
+  destroy_on(worker0,in0);
+  destroy_on(feed,part1);
+  destroy_on(feed,part0);
+  destroy_on(feed,ticks);
+}
@@ -0,0 +1,48 @@
+/* Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+ 
+#include <iostream>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "urp.hpp"
+#include "urp_shm.hpp"
+
+struct tick
+{
+  int    symbol;
+  double price;
+};
+
+int main()
+{
+  using namespace usingstdcpp2019::urp;
+
+  /* the publisher must exist before anyone subscribes */
+
+  shm_publisher<tick> pub{"urp_shm_example",64};
+  if(fork()==0){ /* feed handler process */
+    for(int i=0;i<1000;++i)pub.publish(tick{i%3,100.0+i%7});
+    while(!pub.drained())usleep(100);
+    _exit(0);
+  }
+
+  shm_subscriber<tick> sub{"urp_shm_example"};
+  trigger<tick>        s;
+  auto                 total=hold(
+    s|filter([](const tick& t){return t.symbol==0;})
+     |map([](const tick& t){return t.price;})
+     |accumulate(0.0,std::plus<>{}));
+
+  for(std::size_t n=0;n<1000;){
+    auto m=sub.poll(s);
+    if(!m)usleep(100);
+    n+=m;
+  }
+  wait(nullptr);
+  std::cout<<"total price for symbol 0: "<<total.get()<<"\n";
+}
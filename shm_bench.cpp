@@ -0,0 +1,70 @@
+/* Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+ 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "urp.hpp"
+#include "urp_shm.hpp"
+
+struct tick
+{
+  std::int64_t timestamp;
+  std::int32_t symbol;
+  std::int32_t quantity;
+  double       price;
+};
+
+std::int64_t now()
+{
+  /* steady_clock is CLOCK_MONOTONIC, comparable across processes */
+
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int main(int argc,char** argv)
+{
+  using namespace usingstdcpp2019::urp;
+
+  std::size_t n=argc>1?std::strtoull(argv[1],nullptr,10):100000;
+
+  /* one tick in flight at a time: measures publish to graph latency */
+
+  shm_publisher<tick> pub{"urp_shm_bench"};
+  if(fork()==0){
+    for(std::size_t i=0;i<n;++i){
+      pub.publish(tick{now(),std::int32_t(i%64),1,100.0+i%10});
+      while(!pub.drained())std::this_thread::yield();
+    }
+    _exit(0);
+  }
+
+  shm_subscriber<tick>      sub{"urp_shm_bench"};
+  trigger<tick>             s;
+  std::vector<std::int64_t> latencies;
+  latencies.reserve(n);
+  s.connect([&](const auto&,const tick& t){
+    latencies.push_back(now()-t.timestamp);
+  });
+  while(latencies.size()<n){
+    if(!sub.poll(s))std::this_thread::yield();
+  }
+  wait(nullptr);
+
+  std::sort(latencies.begin(),latencies.end());
+  auto pct=[&](double p){return latencies[std::size_t(p*(n-1))];};
+  std::cout<<"publish to graph latency: median "<<pct(0.5)<<" ns, p99 "
+           <<pct(0.99)<<" ns, max "<<latencies.back()<<" ns\n";
+}
@@ -0,0 +1,61 @@
+/* Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+ 
+#include <iostream>
+#include <string>
+#include "urp.hpp"
+
+int main()
+{
+  using namespace usingstdcpp2019::urp;
+
+  auto names={
+    "John","Jack","Susan","Mary","Anne","Anthony","Bjarne","Margaret",
+    "George","Barack","Sarah","Peter","Hillary","Ronda","Alice","Herbert",
+  };
+  auto half=names.begin()+names.size()/2;
+
+  auto make_graph=[]{
+    return [](trigger<std::string>& s){
+      return std::tuple{
+        hold(
+          s|group_by([](const std::string& str){return str.c_str()[0];})
+           |map([](auto e){
+             return hold(std::move(e)|collect());
+           })
+           |collect()
+        ),
+        hold(
+          s|map([](const std::string& str){return str.size();})
+           |accumulate(std::size_t(0),std::plus<>{}))
+      };
+    };
+  }();
+  auto print=[](const auto& res,const auto& length){
+    for(const auto& e:res.get()){
+      for(const auto& str:e.get())std::cout<<str<<" ";
+      std::cout<<"\n";
+    }
+    std::cout<<"total length: "<<length.get()<<"\n";
+  };
+
+  std::string snapshot;
+  {
+    trigger<std::string> s;
+    auto [res,length]=make_graph(s);
+    for(auto it=names.begin();it!=half;++it)s=*it;
+    snapshot=save_snapshot(res,length);
+  }
+  std::cout<<"snapshot: "<<snapshot.size()<<" bytes\n";
+  
+  trigger<std::string> s;
+  auto [res,length]=make_graph(s);
+  load_snapshot(snapshot,res,length);
+  for(auto it=half;it!=names.end();++it)s=*it;
+  print(res,length);
+}
@@ -0,0 +1,59 @@
+/* Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+ 
+#include <functional>
+#include <iostream>
+#include "urp.hpp"
+
+int main()
+{
+  using namespace usingstdcpp2019::urp;
+
+  value x=0;
+    
+  auto f=[](int x){return x+1;};
+  auto g=[](int x){return 2*x;};
+  auto h=[](int x){return x*(x+1);};
+
+  auto z=x|f|g|h;
+  auto z1=x|chain(f,g,h); /* one node, same result */
+
+  x=2;
+  std::cout<<"z ="<<z.get()<<"\n"
+           <<"z1="<<z1.get()<<"\n";
+
+  auto odd=filter([](int x){return x%2!=0;});
+  auto sq=map([](int x){return x*x;});
+  auto sum=accumulate(0,std::plus<>{});
+
+  trigger<int> s;
+  auto         e=hold(s|odd|sq|sum);
+  auto         e1=hold(s|stages(odd,sq,sum));
+
+  /* downstream of a boundary, types no longer depend on the upstream */
+
+  any_event<int> a=s|stages(odd,sq);
+  auto           e2=hold(a|sum);
+
+  for(int i=0;i<10;++i)s=i;
+  std::cout<<"e ="<<e.get()<<"\n"
+           <<"e1="<<e1.get()<<"\n"
+           <<"e2="<<e2.get()<<"\n";
+
+  /* state of every stage goes into snapshots */
+
+  auto snapshot=save_snapshot(e1,a,e2);
+  trigger<int> s2;
+  auto         r1=hold(s2|stages(odd,sq,sum));
+  any_event    a2=s2|stages(odd,sq);
+  auto         r2=hold(a2|sum);
+  load_snapshot(snapshot,r1,a2,r2);
+  s2=11;
+  std::cout<<"r1="<<r1.get()<<"\n"
+           <<"r2="<<r2.get()<<"\n";
+}
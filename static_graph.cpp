@@ -0,0 +1,34 @@
+/* Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+ 
+#include <iostream>
+#include "urp_static.hpp"
+
+int main()
+{
+  using namespace usingstdcpp2019::urp;
+
+  auto f=[](int x){return x+1;};
+  auto g=[](int x){return 2*x;};
+  auto h=[](int x){return x*(x+1);};
+
+  /* same as z=x|f|g|h, plus s=x+z reading two levels of the chain */
+
+  static_graph gr{
+    static_value<struct x>(0),
+    static_function<struct y,x>(f),
+    static_function<struct w,y>(g),
+    static_function<struct z,w>(h),
+    static_function<struct s,x,z>([](int x,int z){return x+z;})
+  };
+
+  gr.set<x>(2);
+  std::cout<<"z="<<gr.get<z>()<<"\n"
+           <<"s="<<gr.get<s>()<<"\n"
+           <<"sizeof(gr)="<<sizeof(gr)<<"\n";
+}
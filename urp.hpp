@@ -15,11 +15,27 @@
 #pragma once
 #endif
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <boost/container_hash/hash.hpp>
 #include <boost/signals2/signal.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <list>
+#include <map>
+#include <memory>
 #include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <tuple>
 #include <type_traits>
+#include <typeinfo>
 #include <unordered_map>
 #include <utility>
 #include <variant>
@@ -27,6 +43,283 @@
 
 namespace usingstdcpp2019::urp{
 
+class snapshot_writer;
+class snapshot_reader;
+
+namespace detail{
+
+template<typename T,typename=void>
+struct has_save_member:std::false_type{};
+template<typename T>
+struct has_save_member<
+  T,
+  std::void_t<decltype(
+    std::declval<const T&>().save(std::declval<snapshot_writer&>()))>
+>:std::true_type{};
+
+template<typename T>
+void save(snapshot_writer&,const T&);
+template<typename T>
+void load(snapshot_reader&,T&);
+template<typename C,typename Tr,typename A>
+void save(snapshot_writer&,const std::basic_string<C,Tr,A>&);
+template<typename C,typename Tr,typename A>
+void load(snapshot_reader&,std::basic_string<C,Tr,A>&);
+template<typename T>
+void save(snapshot_writer&,const std::optional<T>&);
+template<typename T>
+void load(snapshot_reader&,std::optional<T>&);
+template<typename... Ts>
+void save(snapshot_writer&,const std::tuple<Ts...>&);
+template<typename... Ts>
+void load(snapshot_reader&,std::tuple<Ts...>&);
+template<typename T,typename U>
+void save(snapshot_writer&,const std::pair<T,U>&);
+template<typename T,typename U>
+void load(snapshot_reader&,std::pair<T,U>&);
+template<typename T,typename A>
+void save(snapshot_writer&,const std::vector<T,A>&);
+template<typename T,typename A>
+void load(snapshot_reader&,std::vector<T,A>&);
+template<typename T,typename A>
+void save(snapshot_writer&,const std::deque<T,A>&);
+template<typename T,typename A>
+void load(snapshot_reader&,std::deque<T,A>&);
+template<typename K,typename T,typename C,typename A>
+void save(snapshot_writer&,const std::map<K,T,C,A>&);
+template<typename K,typename T,typename C,typename A>
+void load(snapshot_reader&,std::map<K,T,C,A>&);
+template<typename K,typename T,typename H,typename P,typename A>
+void save(snapshot_writer&,const std::unordered_map<K,T,H,P,A>&);
+template<typename K,typename T,typename H,typename P,typename A>
+void load(snapshot_reader&,std::unordered_map<K,T,H,P,A>&);
+
+} /* namespace detail */
+
+/* compact binary image of the state of a graph: every node and stateful
+ * operator writes its state with save and reads it back in the same order
+ * with load into a freshly built graph of the same shape.
+ */
+
+class snapshot_writer
+{
+public:
+  template<typename T>
+  snapshot_writer& operator<<(const T& x)
+  {
+    detail::save(*this,x);
+    return *this;
+  }
+
+  void write(const void* p,std::size_t n)
+  {
+    buf.append(static_cast<const char*>(p),n);
+  }
+
+  const std::string& data()const noexcept{return buf;}
+
+private:
+  std::string buf;
+};
+
+class snapshot_reader
+{
+public:
+  explicit snapshot_reader(std::string_view buf):buf{buf}{}
+
+  template<typename T>
+  snapshot_reader& operator>>(T& x)
+  {
+    detail::load(*this,x);
+    return *this;
+  }
+
+  void read(void* p,std::size_t n)
+  {
+    if(n>buf.size())throw std::runtime_error{"truncated snapshot"};
+    std::memcpy(p,buf.data(),n);
+    buf.remove_prefix(n);
+  }
+
+  bool done()const noexcept{return buf.empty();}
+
+private:
+  std::string_view buf;
+};
+
+namespace detail{
+
+template<typename T>
+void save(snapshot_writer& w,const T& x)
+{
+  if constexpr(has_save_member<T>::value){
+    x.save(w);
+  }
+  else{
+    static_assert(
+      std::is_trivially_copyable_v<T>,"type can't be saved to a snapshot");
+    w.write(&x,sizeof(T));
+  }
+}
+
+template<typename T>
+void load(snapshot_reader& r,T& x)
+{
+  if constexpr(has_save_member<T>::value){
+    x.load(r);
+  }
+  else{
+    static_assert(
+      std::is_trivially_copyable_v<T>,"type can't be loaded from a snapshot");
+    r.read(&x,sizeof(T));
+  }
+}
+
+template<typename Size>
+Size load_size(snapshot_reader& r)
+{
+  std::uint64_t n;
+  r>>n;
+  return static_cast<Size>(n);
+}
+
+template<typename C,typename Tr,typename A>
+void save(snapshot_writer& w,const std::basic_string<C,Tr,A>& x)
+{
+  w<<std::uint64_t(x.size());
+  w.write(x.data(),x.size()*sizeof(C));
+}
+
+template<typename C,typename Tr,typename A>
+void load(snapshot_reader& r,std::basic_string<C,Tr,A>& x)
+{
+  x.resize(load_size<std::size_t>(r));
+  r.read(x.data(),x.size()*sizeof(C));
+}
+
+template<typename T>
+void save(snapshot_writer& w,const std::optional<T>& x)
+{
+  w<<bool(x);
+  if(x)w<<*x;
+}
+
+template<typename T>
+void load(snapshot_reader& r,std::optional<T>& x)
+{
+  bool b;
+  r>>b;
+  if(b){
+    if(!x)x.emplace();
+    r>>*x;
+  }
+  else x.reset();
+}
+
+template<typename... Ts>
+void save(snapshot_writer& w,const std::tuple<Ts...>& x)
+{
+  std::apply([&](const auto&... xs){(w<<...<<xs);},x);
+}
+
+template<typename... Ts>
+void load(snapshot_reader& r,std::tuple<Ts...>& x)
+{
+  std::apply([&](auto&... xs){(r>>...>>xs);},x);
+}
+
+template<typename T,typename U>
+void save(snapshot_writer& w,const std::pair<T,U>& x){w<<x.first<<x.second;}
+
+template<typename T,typename U>
+void load(snapshot_reader& r,std::pair<T,U>& x){r>>x.first>>x.second;}
+
+template<typename Sequence>
+void save_sequence(snapshot_writer& w,const Sequence& x)
+{
+  w<<std::uint64_t(x.size());
+  for(const auto& e:x)w<<e;
+}
+
+/* elements that can't be default constructed (e.g. holds produced by a
+ * group_by) are not recreated but loaded in place: the structure must have
+ * been rebuilt already by the operators upstream.
+ */
+
+template<typename Sequence>
+void load_sequence(snapshot_reader& r,Sequence& x)
+{
+  auto n=load_size<typename Sequence::size_type>(r);
+  if constexpr(std::is_default_constructible_v<typename Sequence::value_type>){
+    x.clear();
+    x.resize(n);
+  }
+  else if(x.size()!=n){
+    throw std::runtime_error{"snapshot does not match graph structure"};
+  }
+  for(auto& e:x)r>>e;
+}
+
+template<typename T,typename A>
+void save(snapshot_writer& w,const std::vector<T,A>& x){save_sequence(w,x);}
+
+template<typename T,typename A>
+void load(snapshot_reader& r,std::vector<T,A>& x){load_sequence(r,x);}
+
+template<typename T,typename A>
+void save(snapshot_writer& w,const std::deque<T,A>& x){save_sequence(w,x);}
+
+template<typename T,typename A>
+void load(snapshot_reader& r,std::deque<T,A>& x){load_sequence(r,x);}
+
+template<typename Map>
+void load_map(snapshot_reader& r,Map& x)
+{
+  x.clear();
+  for(auto n=load_size<std::size_t>(r);n--;){
+    typename Map::key_type    k;
+    typename Map::mapped_type v;
+    r>>k>>v;
+    x.emplace(std::move(k),std::move(v));
+  }
+}
+
+template<typename K,typename T,typename C,typename A>
+void save(snapshot_writer& w,const std::map<K,T,C,A>& x){save_sequence(w,x);}
+
+template<typename K,typename T,typename C,typename A>
+void load(snapshot_reader& r,std::map<K,T,C,A>& x){load_map(r,x);}
+
+template<typename K,typename T,typename H,typename P,typename A>
+void save(snapshot_writer& w,const std::unordered_map<K,T,H,P,A>& x)
+{
+  save_sequence(w,x);
+}
+
+template<typename K,typename T,typename H,typename P,typename A>
+void load(snapshot_reader& r,std::unordered_map<K,T,H,P,A>& x)
+{
+  load_map(r,x);
+}
+
+} /* namespace detail */
+
+template<typename... Nodes>
+std::string save_snapshot(const Nodes&... nodes)
+{
+  snapshot_writer w;
+  (w<<...<<nodes);
+  return w.data();
+}
+
+template<typename... Nodes>
+void load_snapshot(std::string_view data,Nodes&... nodes)
+{
+  snapshot_reader r{data};
+  (r>>...>>nodes);
+  if(!r.done())throw std::runtime_error{"snapshot does not match graph"};
+}
+
 namespace detail{
 
 template<typename... Ts> struct overloaded:Ts...{using Ts::operator()...;};
@@ -35,6 +328,89 @@ template<typename... Ts> overloaded(Ts...)->overloaded<Ts...>;
 template<std::size_t I>
 using node_index_type=std::integral_constant<std::size_t,I>;
 
+/* Profiling hooks, installed at run time (see urp_profile.hpp) so that
+ * the code instantiated is the same whether profiling is used or not.
+ * They're always compiled in: every node callback and propagating signal
+ * pays a relaxed atomic load and a branch, plus the hook calls themselves
+ * when installed. The pointer is atomic as shards read it from their own
+ * threads.
+ */
+
+struct profile_hooks
+{
+  void (*enter)(const void*,const std::type_info&);
+  void (*exit)();
+  bool (*active)();
+};
+
+inline std::atomic<const profile_hooks*> profiling=nullptr;
+
+/* frame for a node callback */
+
+class profile_scope
+{
+public:
+  template<typename Node>
+  profile_scope(const Node& n):h{profiling.load(std::memory_order_relaxed)}
+  {
+    if(h)h->enter(&n,typeid(Node));
+  }
+  profile_scope(const profile_scope&)=delete;
+  ~profile_scope(){if(h)h->exit();}
+
+  profile_scope& operator=(const profile_scope&)=delete;
+
+private:
+  const profile_hooks* h;
+};
+
+/* frame for a signalling node, only if it starts a propagation */
+
+class profile_root_scope
+{
+public:
+  template<typename Node>
+  profile_root_scope(const Node& n):
+    h{profiling.load(std::memory_order_relaxed)}
+  {
+    if(h&&h->active())h=nullptr;
+    if(h)h->enter(&n,typeid(Node));
+  }
+  profile_root_scope(const profile_root_scope&)=delete;
+  ~profile_root_scope(){if(h)h->exit();}
+
+  profile_root_scope& operator=(const profile_root_scope&)=delete;
+
+private:
+  const profile_hooks* h;
+};
+
+/* signal payload for single-consumer emissions: the only slot connected
+ * receives the value as an rvalue and may move from it.
+ */
+
+template<typename... SigArgs> struct rvalue_sigargs;
+
+template<typename NodeArg,typename Arg>
+struct rvalue_sigargs<NodeArg,Arg>
+{
+  auto lvalues()const{return std::forward_as_tuple(*n,std::as_const(*x));}
+  auto rvalues()const{return std::forward_as_tuple(*n,std::move(*x));}
+
+  std::remove_reference_t<NodeArg>*                   n;
+  std::remove_cv_t<std::remove_reference_t<Arg>>*     x;
+};
+
+template<typename... SigArgs>
+auto& slot_args(std::tuple<SigArgs...>& t){return t;}
+template<typename... SigArgs>
+auto slot_args(const rvalue_sigargs<SigArgs...>& r){return r.lvalues();}
+
+template<typename... SigArgs>
+auto& node_args(std::tuple<SigArgs...>& t){return t;}
+template<typename... SigArgs>
+auto node_args(const rvalue_sigargs<SigArgs...>& r){return r.rvalues();}
+
 template<typename Derived,typename Signature,typename... Srcs>
 class node;
 
@@ -78,28 +454,76 @@ public:
     return connect_node([=](auto arg){
       std::visit(overloaded{
         [](node*){},
-        [=](auto& sigargs){std::apply(s,sigargs);}
+        [=](auto& sigargs){std::apply(s,slot_args(sigargs));}
       },arg);
+      return true;
     });
   }
 
 protected:
-  void signal(SigArgs... sigargs)
+  /* returns the number of observers reached, passive slots excluded */
+
+  std::size_t signal(SigArgs... sigargs)
+  {
+    profile_root_scope ps{static_cast<Derived&>(*this)};
+    return sig(std::forward_as_tuple(std::forward<SigArgs>(sigargs)...));
+  }
+
+  /* moves x into the only slot, if there's one; num_slots() also counts
+   * passive slots of suspended dependents, so a node with one live and
+   * some suspended dependents falls back to copying
+   */
+
+  template<typename NodeArg,typename Arg>
+  void signal_rvalue(const NodeArg& n,Arg&& x)
   {
-    sig(std::forward_as_tuple(std::forward<SigArgs>(sigargs)...));
+    profile_root_scope ps{static_cast<Derived&>(*this)};
+    if(sig.num_slots()>1)signal(n,x);
+    else sig(rvalue_sigargs<SigArgs...>{&n,&x});
   }
 
   auto get_srcs()const noexcept{return std::tuple{};}
+
+  void demand(){}
     
 private:
   template<typename,typename,typename...> friend class node;
 
-  using extended_signature=void(std::variant<node*,std::tuple<SigArgs...>>);
+  /* slots return whether they observe the node: suspended dependents stay
+   * connected, but only to follow the node around when moved
+   */
+
+  struct count_observers
+  {
+    using result_type=std::size_t;
+
+    template<typename InputIterator>
+    result_type operator()(InputIterator first,InputIterator last)const
+    {
+      result_type n=0;
+      for(;first!=last;++first)n+=*first;
+      return n;
+    }
+  };
+
+  using extended_signature=bool(std::conditional_t<
+    sizeof...(SigArgs)==2,
+    std::variant<
+      node*,std::tuple<SigArgs...>,rvalue_sigargs<SigArgs...>>,
+    std::variant<node*,std::tuple<SigArgs...>>
+  >);
 
   template<typename Slot>
-  auto connect_node(const Slot& s){return sig.connect(s);}
+  auto connect_node(const Slot& s)
+  {
+    auto c=sig.connect(s);
+    demand_node();
+    return c;
+  }
+
+  void demand_node(){static_cast<Derived*>(this)->demand();}
 
-  boost::signals2::signal<extended_signature> sig;
+  boost::signals2::signal<extended_signature,count_observers> sig;
 };
 
 template<typename Derived,typename... SigArgs,typename... Srcs>
@@ -167,6 +591,20 @@ public:
 protected:
   auto& get_srcs()const noexcept{return srcs;}
 
+  bool suspended()const noexcept{return passive;}
+
+  /* suspension keeps the connections, so it's a matter of flipping a flag
+   * (plus waking up suspended sources on resumption)
+   */
+
+  void suspend_srcs()const noexcept{passive=true;}
+
+  void resume_srcs()const
+  {
+    passive=false;
+    std::apply([](auto*... srcs){(srcs->demand_node(),...);},srcs);
+  }
+
 private:
   template<typename,typename,typename...> friend class node;
 
@@ -184,20 +622,24 @@ private:
   struct slot
   {
     template<typename Arg>
-    void operator()(Arg arg)const{
+    bool operator()(Arg arg)const{
+      bool active=!this_->passive;
       std::visit(overloaded{
         [this](auto* p){
           auto& src=std::get<I>(this_->srcs);
           src=static_cast<std::decay_t<decltype(src)>>(p);
         },
-        [this](auto& sigargs){
+        [&,this](auto& sigargs){
+          if(!active)return;
+          profile_scope ps{this_->derived()};
           std::apply([this](auto&&... sigargs){
             this_->derived().callback(
               node_index_type<I>{},
               std::forward<decltype(sigargs)>(sigargs)...);
-          },sigargs);
+          },node_args(sigargs));
         }
       },arg);
+      return active;
     }
 
     node* this_;
@@ -218,19 +660,23 @@ private:
   {
     return std::array{
       std::get<I>(srcs)->connect_node([this](auto arg){
+        bool active=!passive;
         std::visit(overloaded{
           [this](auto* p){
             auto& src=std::get<I>(srcs);
             src=static_cast<std::decay_t<decltype(src)>>(p);
           },
-          [this](auto& sigargs){
+          [&,this](auto& sigargs){
+            if(!active)return;
+            profile_scope ps{derived()};
             std::apply([this](auto&&... sigargs){
               derived().callback(
                 node_index_type<I>{},
                 std::forward<decltype(sigargs)>(sigargs)...);
-            },sigargs);
+            },node_args(sigargs));
           }
         },arg);
+        return active;
       })...
     };
   }
@@ -240,10 +686,12 @@ private:
   void disconnect_srcs()
   {
     std::apply([](auto&&... conns){(conns.disconnect(),...);},conns);
+    passive=false;
   }
 
   std::tuple<Srcs*...>                                    srcs;
   std::array<boost::signals2::connection,sizeof...(Srcs)> conns=connect_srcs();
+  mutable bool                                            passive=false;
 };
 
 } /* namespace detail */
@@ -299,6 +747,15 @@ public:
   }
 
   const T& get()const noexcept{return t;}
+
+  void save(snapshot_writer& w)const{w<<t;}
+
+  void load(snapshot_reader& r)
+  {
+    T u=t;
+    r>>u;
+    *this=std::move(u);
+  }
   
   template<typename F>
   auto operator|(F f)&{return function{f,*this};}
@@ -314,11 +771,50 @@ void swap(value<T>& x,value<T>& y){x.swap(y);}
 
 namespace detail{
 
+/* composed unary stages are kept as a flat list rather than as nested
+ * closures, so that long pipes don't produce deeply nested types
+ */
+
+template<typename... Fs>
+class function_chain
+{
+public:
+  function_chain(Fs... fs):fs{fs...}{}
+
+  template<typename... Args>
+  auto operator()(Args&&... args)const
+  {
+    return apply<1>(std::get<0>(fs)(std::forward<Args>(args)...));
+  }
+
+  template<typename G>
+  auto then(G g)const
+  {
+    return std::apply([&](const auto&... f){
+      return function_chain<Fs...,G>{f...,g};},fs);
+  }
+
+private:
+  template<std::size_t I,typename T>
+  auto apply(T&& x)const
+  {
+    if constexpr(I==sizeof...(Fs))return std::forward<T>(x);
+    else return apply<I+1>(std::get<I>(fs)(std::forward<T>(x)));
+  }
+
+  std::tuple<Fs...> fs;
+};
+
+template<typename F>
+struct is_function_chain:std::false_type{};
+template<typename... Fs>
+struct is_function_chain<function_chain<Fs...>>:std::true_type{};
+
 template<typename F1,typename F2>
 auto compose_function(F1 f1,F2 f2)
 {
-  return[=](auto&&... x){
-    return f1(f2(std::forward<decltype(x)>(x)...));};
+  if constexpr(is_function_chain<F2>::value)return f2.then(f1);
+  else return function_chain<F2,F1>{f2,f1};
 }
 
 template<std::size_t I0,typename Tuple,std::size_t... I>
@@ -374,8 +870,9 @@ public:
   using value_type=decltype(std::declval<F>()(std::declval<Args>().get()...));
     
   function(F f,Args&... args):super{args...},f{f}{}
-  function(const function& x)=default;
-  function(function&& x)=default;
+  function(const function& x):
+    super{x},f{x.f},t{x.suspended()?value():x.t}{}
+  function(function&& x):function{std::move(x),x.suspended()}{}
   template<typename F1,typename F2>
   function(F1 f1,function<F2,Args...>&& x):
     super{std::move(x)},f{detail::compose_function(f1,x.f)}{}
@@ -404,17 +901,42 @@ public:
     return *this;
   }
 
-  function& operator=(function&& x)=default;
+  function& operator=(function&& x)
+  {
+    if(this!=&x){
+      bool stale=x.suspended();
+      base()=std::move(x.base());
+      f=std::move(x.f);
+      t=stale?value():std::move(x.t);
+    }
+    return *this;
+  }
 
   void swap(function& x)
   {
     using std::swap;
+    bool stale=this->suspended(),x_stale=x.suspended();
     base().swap(x.base());
     swap(f,x.f);
     swap(t,x.t);
+    if(x_stale)t=value();
+    if(stale)x.t=x.value();
+  }
+
+  /* reading a suspended function recomputes it: get() may throw whatever
+   * f throws and, though const, writes the cached value, so concurrent
+   * reads of the same function must be synchronized by the caller
+   */
+
+  auto const& get()const
+  {
+    demand();
+    read=true;
+    return t;
   }
 
-  auto const& get()const noexcept{return t;}
+  void save(snapshot_writer&)const{}
+  void load(snapshot_reader&){update();}
     
   template<typename G>
   auto operator|(G g)& {return urp::function{g,*this};}
@@ -423,12 +945,25 @@ public:
 
 private:
   friend super;
+  friend detail::node<function,void(const function&)>;
   template<typename,typename...> friend class function;
 
+  function(function&& x,bool stale):
+    super{std::move(x)},f{std::move(x.f)},
+    t{stale?value():std::move(x.t)}{}
+
   super& base()noexcept{return *this;}
 
   template<typename Index,typename Arg>
   void callback(Index,const Arg&){update();}
+
+  void demand()const
+  {
+    if(this->suspended()){
+      this->resume_srcs();
+      t=value();
+    }
+  }
   
   auto value()const
   {
@@ -436,16 +971,22 @@ private:
       return f(args->get()...);},this->get_srcs());
   }
 
+  /* a change reaching no observer, with no read since the previous one,
+   * suspends the function until it's next connected to or read
+   */
+
   void update()
   {
     if(const auto& u=value();!(t==u)){
       t=u;
-      this->signal(*this);
+      bool was_read=std::exchange(read,false);
+      if(!this->signal(*this)&&!was_read)this->suspend_srcs();
     }
   }
   
-  F          f;
-  value_type t=value();
+  F                  f;
+  mutable value_type t=value();
+  mutable bool       read=false;
 };
 
 template<typename F1,typename F2,typename... Args>
@@ -483,45 +1024,179 @@ function(F1,Arg2&,function<F3,Args3...>&&)->function<
 template<typename F,typename... Args>
 void swap(function<F,Args...>& x,function<F,Args...>& y){x.swap(y);}
 
+/* x|chain(f,g,h) computes h(g(f(x))) in a single node, without the
+ * intermediate nodes of x|f|g|h
+ */
+
+template<typename F,typename... Fs>
+auto chain(F f,Fs... fs){return detail::function_chain<F,Fs...>{f,fs...};}
+
 namespace detail{
 
-template<typename T>
-struct is_function_or_value_impl:std::false_type{};
-template<typename T>
-struct is_function_or_value_impl<value<T>>:std::true_type{};
-template<typename F,typename... Args>
-struct is_function_or_value_impl<function<F,Args...>>:std::true_type{};
-template<typename T>
-inline constexpr bool is_function_or_value=
-  is_function_or_value_impl<std::decay_t<T>>::value;
+/* least recently used entries are recycled in place, so that a full cache
+ * doesn't allocate
+ */
 
-} /* namespace detail */
+template<typename Key,typename T>
+class lru_cache
+{
+public:
+  explicit lru_cache(std::size_t capacity):capacity{capacity}
+  {
+    index.reserve(capacity);
+  }
 
-#define USINGSTDCPP2019_URP_DEFINE_UNARY_OP(name)             \
-template<                                                     \
-  typename T,                                                 \
-  std::enable_if_t<detail::is_function_or_value<T>>* =nullptr \
->                                                             \
-auto operator name(T&& x)                                     \
-{                                                             \
-  return function{                                            \
-    [](const auto& x){return name x;},                        \
-    std::forward<T>(x)                                        \
-  };                                                          \
-}
+  std::size_t size()const noexcept{return index.size();}
 
-#define USINGSTDCPP2019_URP_DEFINE_BINARY_OP(name)            \
-template<                                                     \
-  typename T,typename U,                                      \
-  std::enable_if_t<                                           \
-    !detail::is_function_or_value<T>&&                        \
-    detail::is_function_or_value<U>                           \
-  >* =nullptr                                                 \
->                                                             \
-auto operator name(T&& x,U&& y)                               \
-{                                                             \
-  return function{                                            \
-    [x=std::forward<T>(x)](const auto& y){return x name y;},  \
+  const T* find(const Key& k)
+  {
+    auto it=index.find(k);
+    if(it==index.end())return nullptr;
+    entries.splice(entries.begin(),entries,it->second);
+    return &it->second->second;
+  }
+
+  const T& insert(const Key& k,T x)
+  {
+    if(index.size()<capacity){
+      entries.emplace_front(k,std::move(x));
+      index.emplace(k,entries.begin());
+    }
+    else{
+      entries.splice(entries.begin(),entries,std::prev(entries.end()));
+      auto nh=index.extract(entries.front().first);
+      entries.front()={k,std::move(x)};
+      nh.key()=k;
+      index.insert(std::move(nh));
+    }
+    return entries.front().second;
+  }
+
+private:
+  using entry_list=std::list<std::pair<Key,T>>;
+
+  std::size_t                                                    capacity;
+  entry_list                                                     entries;
+  std::unordered_map<
+    Key,typename entry_list::iterator,boost::hash<Key>>          index;
+};
+
+/* argument types of a callable with a single, non-template operator() */
+
+template<typename F>
+struct callable_args:callable_args<decltype(&F::operator())>{};
+template<typename R,typename... Args>
+struct callable_args<R(Args...)>
+{
+  using type=std::tuple<std::decay_t<Args>...>;
+};
+template<typename R,typename... Args>
+struct callable_args<R(*)(Args...)>:callable_args<R(Args...)>{};
+template<typename R,typename... Args>
+struct callable_args<R(*)(Args...)noexcept>:callable_args<R(Args...)>{};
+template<typename R,typename C,typename... Args>
+struct callable_args<R(C::*)(Args...)>:callable_args<R(Args...)>{};
+template<typename R,typename C,typename... Args>
+struct callable_args<R(C::*)(Args...)const>:callable_args<R(Args...)>{};
+template<typename R,typename C,typename... Args>
+struct callable_args<R(C::*)(Args...)noexcept>:callable_args<R(Args...)>{};
+template<typename R,typename C,typename... Args>
+struct callable_args<R(C::*)(Args...)const noexcept>:
+  callable_args<R(Args...)>{};
+
+template<typename Key,typename T>
+struct memo_state
+{
+  explicit memo_state(std::size_t capacity):
+    capacity{capacity},cache{capacity}{}
+
+  std::size_t      capacity,hits=0,misses=0;
+  lru_cache<Key,T> cache;
+};
+
+} /* namespace detail */
+
+/* f with results cached by argument values in a bounded LRU cache keyed on
+ * f's own (decayed) argument types, so f can't be generic or overloaded;
+ * copies share the cache and its counters
+ */
+
+template<typename F,typename Key=typename detail::callable_args<F>::type>
+class memoized;
+
+template<typename F,typename... Args>
+class memoized<F,std::tuple<Args...>>
+{
+  using key_type=std::tuple<Args...>;
+  using result_type=std::decay_t<std::invoke_result_t<const F&,Args&...>>;
+  using state_type=detail::memo_state<key_type,result_type>;
+
+public:
+  memoized(F f,std::size_t capacity):
+    f{f},st{std::make_shared<state_type>(capacity?capacity:1)}{}
+
+  result_type operator()(const Args&... args)const
+  {
+    key_type k{args...};
+    if(auto p=st->cache.find(k)){
+      ++st->hits;
+      return *p;
+    }
+    ++st->misses;
+    return st->cache.insert(k,f(args...));
+  }
+
+  std::size_t capacity()const noexcept{return st->capacity;}
+  std::size_t hits()const noexcept{return st->hits;}
+  std::size_t misses()const noexcept{return st->misses;}
+
+private:
+  F                           f;
+  std::shared_ptr<state_type> st;
+};
+
+template<typename F>
+auto memoize(F f,std::size_t capacity){return memoized<F>{f,capacity};}
+
+namespace detail{
+
+template<typename T>
+struct is_function_or_value_impl:std::false_type{};
+template<typename T>
+struct is_function_or_value_impl<value<T>>:std::true_type{};
+template<typename F,typename... Args>
+struct is_function_or_value_impl<function<F,Args...>>:std::true_type{};
+template<typename T>
+inline constexpr bool is_function_or_value=
+  is_function_or_value_impl<std::decay_t<T>>::value;
+
+} /* namespace detail */
+
+#define USINGSTDCPP2019_URP_DEFINE_UNARY_OP(name)             \
+template<                                                     \
+  typename T,                                                 \
+  std::enable_if_t<detail::is_function_or_value<T>>* =nullptr \
+>                                                             \
+auto operator name(T&& x)                                     \
+{                                                             \
+  return function{                                            \
+    [](const auto& x){return name x;},                        \
+    std::forward<T>(x)                                        \
+  };                                                          \
+}
+
+#define USINGSTDCPP2019_URP_DEFINE_BINARY_OP(name)            \
+template<                                                     \
+  typename T,typename U,                                      \
+  std::enable_if_t<                                           \
+    !detail::is_function_or_value<T>&&                        \
+    detail::is_function_or_value<U>                           \
+  >* =nullptr                                                 \
+>                                                             \
+auto operator name(T&& x,U&& y)                               \
+{                                                             \
+  return function{                                            \
+    [x=std::forward<T>(x)](const auto& y){return x name y;},  \
     std::forward<U>(y)                                        \
   };                                                          \
 }                                                             \
@@ -589,6 +1264,15 @@ public:
     return *this;
   }
 
+  trigger& operator=(T&& t)
+  {
+    this->super::signal_rvalue(*this,std::move(t));
+    return *this;
+  }
+
+  void save(snapshot_writer&)const{}
+  void load(snapshot_reader&){}
+
   template<typename Slot>
   auto operator|(Slot s)&{return event{s,*this};}
 };
@@ -627,10 +1311,48 @@ public:
   template<typename... Args>
   void operator()(Args&&... args){f(std::forward<Args>(args)...);}
 
+  void save(snapshot_writer& w)const
+  {
+    if constexpr(has_save_member<F>::value)f.save(w);
+  }
+
+  template<typename Sig>
+  void load(snapshot_reader& r,Sig& sig)
+  {
+    if constexpr(has_save_member<F>::value)f.load(r,sig);
+  }
+
 private:
   F f;
 };
 
+/* callback with snapshottable state, invoked as f(state,sig,index,x) */
+
+template<typename State,typename F>
+class stateful_callback
+{
+public:
+  stateful_callback(State st,F f):st{std::move(st)},f{f}{}
+
+  template<typename Sig,typename Index,typename Arg>
+  void operator()(Sig& sig,Index index,Arg&& x)
+  {
+    f(st,sig,index,std::forward<Arg>(x));
+  }
+
+  void save(snapshot_writer& w)const{w<<st;}
+
+  template<typename Sig>
+  void load(snapshot_reader& r,Sig&){r>>st;}
+
+private:
+  State st;
+  F     f;
+};
+
+template<typename State,typename F>
+auto stateful(State st,F f){return stateful_callback<State,F>{std::move(st),f};}
+
 template<typename Value,typename F>
 auto callback(F f){return callback_class<Value,F>{f};}
 
@@ -660,18 +1382,113 @@ auto type_passthrough(Callback c)
   };
 }
 
+/* what a stage signals is moved on if it's an rvalue, but lvalues (such as
+ * the state of collect or accumulate) only go downstream as const
+ */
+
+template<typename T>
+decltype(auto) pass_on(T&& x)
+{
+  if constexpr(std::is_lvalue_reference_v<T>)return std::as_const(x);
+  else return std::move(x);
+}
+
+/* composed event callbacks, each stage signalling into the next one */
+
+template<typename... Callbacks>
+class stage_list
+{
+  static constexpr std::size_t N=sizeof...(Callbacks);
+
+public:
+  using value_type=
+    typename std::tuple_element_t<N-1,std::tuple<Callbacks...>>::value_type;
+
+  stage_list(Callbacks... cs):cs{cs...}{}
+
+  template<typename Sig,typename Index,typename Arg>
+  void operator()(Sig& sig,Index index,Arg&& x)
+  {
+    invoke<0>(sig,index,std::forward<Arg>(x));
+  }
+
+  template<typename Callback>
+  auto then(Callback c)const
+  {
+    return std::apply([&](const auto&... cs){
+      return stage_list<Callbacks...,Callback>{cs...,c};},cs);
+  }
+
+  void save(snapshot_writer& w)const
+  {
+    std::apply([&](const auto&... cs){(cs.save(w),...);},cs);
+  }
+
+  template<typename Sig>
+  void load(snapshot_reader& r,Sig& sig){load_from<0>(r,sig);}
+
+private:
+  template<std::size_t I,typename Sig>
+  auto next_sig(Sig& sig)
+  {
+    return [this,&sig](auto&& y){
+      using Y=decltype(y);
+      invoke<I+1>(sig,node_index_type<0>{},pass_on(std::forward<Y>(y)));
+    };
+  }
+
+  template<std::size_t I,typename Sig,typename Index,typename Arg>
+  void invoke(Sig& sig,Index index,Arg&& x)
+  {
+    if constexpr(I+1==N){
+      std::get<I>(cs)(sig,index,std::forward<Arg>(x));
+    }
+    else{
+      auto next=next_sig<I>(sig);
+      std::get<I>(cs)(next,index,std::forward<Arg>(x));
+    }
+  }
+
+  template<std::size_t I,typename Sig>
+  void load_from(snapshot_reader& r,Sig& sig)
+  {
+    if constexpr(I+1==N){
+      std::get<I>(cs).load(r,sig);
+    }
+    else{
+      auto next=next_sig<I>(sig);
+      std::get<I>(cs).load(r,next);
+      load_from<I+1>(r,sig);
+    }
+  }
+
+  std::tuple<Callbacks...> cs;
+};
+
+template<typename Callback>
+struct is_stage_list:std::false_type{};
+template<typename... Callbacks>
+struct is_stage_list<stage_list<Callbacks...>>:std::true_type{};
+
+template<typename Callback>
+auto append_stages(Callback c){return c;}
+
+template<typename Callback,typename Reaction,typename... Reactions>
+auto append_stages(Callback c,Reaction r,Reactions... rs)
+{
+  auto c2=callback_for<Callback>(r);
+  if constexpr(is_stage_list<Callback>::value){
+    return append_stages(c.then(c2),rs...);
+  }
+  else{
+    return append_stages(stage_list<Callback,decltype(c2)>{c,c2},rs...);
+  }
+}
+
 template<typename Reaction,typename Callback>
 auto compose_reaction(Reaction r,Callback c)
 {
-  return [=](auto...)mutable{
-    auto c2=callback_for<Callback>(r);
-    return callback<typename decltype(c2)::value_type>(
-      [=](auto& sig,auto index,const auto& x)mutable{
-        auto sig2=[&](const auto& y){c2(sig,node_index_type<0>{},y);};
-        c(sig2,index,x);
-      }
-    );
-  };
+  return [=](auto...){return append_stages(c,r);};
 }
 
 } /* namespace detail */
@@ -719,6 +1536,15 @@ public:
   template<typename Reaction2>
   auto operator|(Reaction2 r2)&&{return urp::event{r2,std::move(*this)};}
 
+  void save(snapshot_writer& w)const{c.save(w);}
+
+  void load(snapshot_reader& r)
+  {
+    auto sig=[this](auto&& y){
+      emit(detail::pass_on(std::forward<decltype(y)>(y)));};
+    c.load(r,sig);
+  }
+
 private:
   friend super;
   template<typename,typename...> friend class event;
@@ -726,12 +1552,16 @@ private:
   super& base()noexcept{return *this;}
 
   template<typename Index,typename Src,typename T>
-  void callback(Index index,Src&,const T& x)
+  void callback(Index index,Src&,T&& x)
   {
-    auto sig=[this](const value_type& y){this->signal(*this,y);};
-    c(sig,index,x);
+    auto sig=[this](auto&& y){
+      emit(detail::pass_on(std::forward<decltype(y)>(y)));};
+    c(sig,index,std::forward<T>(x));
   }
 
+  void emit(const value_type& y){this->signal(*this,y);}
+  void emit(value_type&& y){this->signal_rvalue(*this,std::move(y));}
+
   detail::callback_type<Reaction,Srcs...> c;
 };
 
@@ -746,6 +1576,110 @@ event(Reaction1,event<Reaction2,Srcs...>&&)->event<
 template<typename Reaction,typename... Srcs>
 void swap(event<Reaction,Srcs...>& x,event<Reaction,Srcs...>& y){x.swap(y);}
 
+/* src|stages(r1,r2,r3) behaves as src|r1|r2|r3 but builds a single node,
+ * with no intermediate event types
+ */
+
+template<typename Reaction,typename... Reactions>
+auto stages(Reaction r,Reactions... rs)
+{
+  return [=](auto... args){return detail::append_stages(r(args...),rs...);};
+}
+
+/* Type erasure boundary: any_event<T> owns the event it's built from and
+ * forwards its values, so that nodes downstream don't carry the upstream
+ * type along. Propagation through the boundary costs an indirect call.
+ */
+
+template<typename T>
+class any_event:
+  public detail::node<any_event<T>,void(const any_event<T>&,const T&)>
+{
+  using super=detail::node<any_event,void(const any_event&,const T&)>;
+
+public:
+  using value_type=T;
+
+  template<
+    typename Event,
+    typename=std::enable_if_t<
+      !std::is_same_v<std::decay_t<Event>,any_event>&&
+      !std::is_lvalue_reference_v<Event>
+    >
+  >
+  any_event(Event&& e):
+    impl{std::make_unique<model<Event>>(std::move(e))}
+  {
+    bind<Event>();
+  }
+  any_event(const any_event&)=delete;
+  any_event(any_event&& x):super{std::move(x)},impl{std::move(x.impl)}
+  {
+    if(impl)impl->self=this;
+  }
+
+  any_event& operator=(const any_event&)=delete;
+  any_event& operator=(any_event&& x)
+  {
+    if(this!=&x){
+      super::operator=(std::move(x));
+      impl=std::move(x.impl);
+      if(impl)impl->self=this;
+    }
+    return *this;
+  }
+
+  /* a moved-from any_event has no state to save or load */
+
+  void save(snapshot_writer& w)const{checked_impl().save(w);}
+  void load(snapshot_reader& r){checked_impl().load(r);}
+
+  template<typename Reaction>
+  auto operator|(Reaction r)&{return event{r,*this};}
+
+private:
+  struct concept_
+  {
+    virtual ~concept_()=default;
+    virtual void save(snapshot_writer&)const=0;
+    virtual void load(snapshot_reader&)=0;
+
+    any_event*                         self=nullptr;
+    boost::signals2::scoped_connection conn;
+  };
+
+  template<typename Event>
+  struct model:concept_
+  {
+    model(Event&& e):e{std::move(e)}{}
+
+    void save(snapshot_writer& w)const override{w<<e;}
+    void load(snapshot_reader& r)override{r>>e;}
+
+    Event e;
+  };
+
+  template<typename Event>
+  void bind()
+  {
+    auto p=static_cast<model<Event>*>(impl.get());
+    p->self=this;
+    p->conn=p->e.connect([p](const auto&,const T& x){
+      p->self->signal(*p->self,x);});
+  }
+
+  concept_& checked_impl()const
+  {
+    if(!impl)throw std::logic_error{"any_event has been moved from"};
+    return *impl;
+  }
+
+  std::unique_ptr<concept_> impl;
+};
+
+template<typename Event>
+any_event(Event&&)->any_event<typename std::decay_t<Event>::value_type>;
+
 template<typename Src>
 class hold:public detail::node<hold<Src>,void(const hold<Src>&),Src>
 {
@@ -772,6 +1706,14 @@ public:
   hold& operator=(hold&& x)=default;
 
   const value_type& get()const noexcept{return v;}
+
+  void save(snapshot_writer& w)const{w<<src<<v;}
+
+  void load(snapshot_reader& r)
+  {
+    r>>src>>v;
+    this->signal(*this);
+  }
       
   template<typename Slot>
   auto operator|(Slot s)&{return event{s,*this};}
@@ -788,6 +1730,13 @@ private:
     this->signal(*this);
   }
 
+  template<typename Index>
+  void callback(Index,const Src&,value_type&& x)
+  {
+    v=std::move(x);
+    this->signal(*this);
+  }
+
   value_type v;
   Src        src;
 };
@@ -796,7 +1745,8 @@ template<typename... Srcs>
 auto merge(Srcs&... srcs)
 {
   return event{
-    detail::type_passthrough([](auto& sig,auto,const auto& x){sig(x);}),
+    detail::type_passthrough([](auto& sig,auto,auto&& x){
+      sig(std::forward<decltype(x)>(x));}),
     srcs...
   };
 }
@@ -808,12 +1758,13 @@ auto combine(Srcs&... srcs)
   using cache_type=std::tuple<std::optional<typename Srcs::value_type>...>;
 
   return event{
-    [=](auto...){return detail::callback<value_type>(
-      [os=cache_type{},remaining=sizeof...(Srcs)]
-      (auto& sig,auto index,const auto& x)mutable{
+    [=](auto...){return detail::callback<value_type>(detail::stateful(
+      std::pair{cache_type{},sizeof...(Srcs)},
+      [](auto& st,auto& sig,auto index,auto&& x){
+        auto& [os,remaining]=st;
         auto& o=std::get<index.value>(os);
         if(!o)--remaining;
-        o=x;
+        o=std::forward<decltype(x)>(x);
         if(!remaining){
           sig(std::apply([](auto&&... os){
             return std::make_tuple(std::move(*os)...);
@@ -822,56 +1773,755 @@ auto combine(Srcs&... srcs)
           remaining=sizeof...(Srcs);
         }
       }
-    );},
+    ));},
     srcs...
   };
 }
 
-template<typename Pred>
-auto filter(Pred pred)
+/* emits the latest value of every source whenever any of them fires, once
+ * all have fired at least once
+ */
+
+template<typename... Srcs>
+auto combine_latest(Srcs&... srcs)
 {
-  return detail::type_passthrough(
-    [=](auto& sig,auto,const auto& x){if(pred(x))sig(x);});
+  using value_type=std::tuple<typename Srcs::value_type...>;
+  using cache_type=std::tuple<std::optional<typename Srcs::value_type>...>;
+
+  return event{
+    [=](auto...){return detail::callback<value_type>(detail::stateful(
+      std::pair{cache_type{},sizeof...(Srcs)},
+      [](auto& st,auto& sig,auto index,auto&& x){
+        auto& [os,remaining]=st;
+        auto& o=std::get<index.value>(os);
+        if(!o)--remaining;
+        o=std::forward<decltype(x)>(x);
+        if(!remaining){
+          sig(std::apply([](const auto&... os){
+            return std::make_tuple(*os...);
+          },os));
+        }
+      }
+    ));},
+    srcs...
+  };
 }
 
-template<typename F>
-auto map(F f)
+/* groups incoming values into vectors of n (which can't be zero), each
+ * emitted once full
+ */
+
+inline auto batch(std::size_t n)
 {
+  if(n==0)throw std::invalid_argument{"batch size must be positive"};
+
   return [=](auto... args){
-    return detail::callback<std::common_type_t<decltype(f(args.get()))>...>(
-      [=](auto& sig,auto,const auto& x){sig(f(x));});
+    using value_type=
+      std::vector<std::common_type_t<std::decay_t<decltype(args.get())>...>>;
+
+    return detail::callback<value_type>(detail::stateful(
+      value_type{},
+      [=](value_type& buf,auto& sig,auto,auto&& x){
+        buf.push_back(std::forward<decltype(x)>(x));
+        if(buf.size()>=n)sig(std::exchange(buf,value_type{}));
+      }
+    ));
   };
 }
 
-template<typename T,typename BynaryOp>
-auto accumulate(T init,BynaryOp op)
+template<typename... Srcs>
+auto merge_batched(std::size_t n,Srcs&... srcs)
 {
-  return [=](auto...){return detail::callback<T>(
-    [=,res=std::move(init)](auto& sig,auto,const auto& x)mutable{
-      res=op(std::move(res),x);
-      sig(res);
-    }
-  );};
+  return event{batch(n),srcs...};
 }
 
-template<typename F>
-auto group_by(F f)
+/* as merge_batched, but the pending batch is also flushed whenever
+ * boundary fires, e.g. at the end of every transaction
+ */
+
+template<typename Boundary,typename... Srcs>
+auto merge_batched_until(Boundary& boundary,std::size_t n,Srcs&... srcs)
 {
-  return [=](auto... args){
-    using arg_type=std::common_type_t<decltype(args.get())...>;
-    using key_type=std::common_type_t<decltype(f(args.get()))...>;
-    using trigger_type=trigger<arg_type>;
-    using value_type=decltype(merge(std::declval<trigger_type&>()));
+  using value_type=
+    std::vector<std::common_type_t<typename Srcs::value_type...>>;
+
+  if(n==0)throw std::invalid_argument{"batch size must be positive"};
+
+  return event{
+    [=](auto...){return detail::callback<value_type>(detail::stateful(
+      value_type{},
+      [=](value_type& buf,auto& sig,auto index,auto&& x){
+        if constexpr(index.value==0){
+          if(!buf.empty())sig(std::exchange(buf,value_type{}));
+        }
+        else{
+          buf.push_back(std::forward<decltype(x)>(x));
+          if(buf.size()>=n)sig(std::exchange(buf,value_type{}));
+        }
+      }
+    ));},
+    boundary,srcs...
+  };
+}
+
+struct join_window
+{
+  std::size_t                         max_count=
+    (std::numeric_limits<std::size_t>::max)();
+  std::chrono::steady_clock::duration max_age=
+    (std::chrono::steady_clock::duration::max)();
+};
+
+namespace detail{
+
+template<typename Key,typename T>
+class join_side
+{
+public:
+  using time_point=std::chrono::steady_clock::time_point;
+
+  template<typename F>
+  void for_each(const Key& k,F f)const
+  {
+    auto [first,last]=index.equal_range(k);
+    for(;first!=last;++first)f(first->second.second);
+  }
+
+  void insert(const Key& k,const T& x,time_point now)
+  {
+    index.emplace(k,std::pair{seq,x});
+    order.push_back({seq++,k,now});
+  }
+
+  /* entry times are saved as ages, as clocks don't survive a restart */
+
+  void save(snapshot_writer& w)const
+  {
+    auto now=std::chrono::steady_clock::now();
+    w<<std::uint64_t(order.size());
+    for(const auto& e:order){
+      auto [first,last]=index.equal_range(e.k);
+      while(first->second.first!=e.seq)++first;
+      w<<e.k<<first->second.second<<(now-e.t).count();
+    }
+  }
+
+  void load(snapshot_reader& r)
+  {
+    auto now=std::chrono::steady_clock::now();
+    index.clear();
+    order.clear();
+    for(auto n=detail::load_size<std::size_t>(r);n--;){
+      Key                                        k;
+      T                                          x;
+      std::chrono::steady_clock::duration::rep   age;
+      r>>k>>x>>age;
+      insert(k,x,now-std::chrono::steady_clock::duration{age});
+    }
+  }
+
+  void expire(const join_window& w,time_point now)
+  {
+    while(!order.empty()&&
+          (order.size()>w.max_count||now-order.front().t>w.max_age)){
+      const auto& e=order.front();
+      auto [first,last]=index.equal_range(e.k);
+      for(;first!=last;++first){
+        if(first->second.first==e.seq){
+          index.erase(first);
+          break;
+        }
+      }
+      order.pop_front();
+    }
+  }
+
+private:
+  struct entry
+  {
+    std::uint64_t seq;
+    Key           k;
+    time_point    t;
+  };
+
+  std::unordered_multimap<Key,std::pair<std::uint64_t,T>> index;
+  std::deque<entry>                                       order;
+  std::uint64_t                                           seq=0;
+};
+
+template<
+  std::size_t J,std::size_t I,
+  typename Sides,typename Key,typename Ptrs,typename Sig
+>
+void join_emit(const Sides& sides,const Key& k,Ptrs& ps,Sig& sig)
+{
+  if constexpr(J==std::tuple_size_v<Sides>){
+    sig(std::apply([](auto... ps){return std::make_tuple(*ps...);},ps));
+  }
+  else if constexpr(J==I){
+    detail::join_emit<J+1,I>(sides,k,ps,sig);
+  }
+  else{
+    std::get<J>(sides).for_each(k,[&](const auto& y){
+      std::get<J>(ps)=&y;
+      detail::join_emit<J+1,I>(sides,k,ps,sig);
+    });
+  }
+}
+
+} /* namespace detail */
+
+template<typename F,typename... Srcs>
+auto join_by(F f,const join_window& w,Srcs&... srcs)
+{
+  static_assert(sizeof...(Srcs)>=2,"join_by needs at least two sources");
+
+  using value_type=std::tuple<typename Srcs::value_type...>;
+  using key_type=std::common_type_t<std::decay_t<
+    decltype(f(std::declval<const typename Srcs::value_type&>()))>...>;
+  using sides_type=std::tuple<
+    detail::join_side<key_type,typename Srcs::value_type>...>;
+  using pointers_type=std::tuple<const typename Srcs::value_type*...>;
+  using clock=std::chrono::steady_clock;
+
+  /* the clock is only read, and entries only expired, if the window has
+   * bounds
+   */
+
+  bool timed=w.max_age!=(clock::duration::max)(),
+       bounded=timed||w.max_count!=(std::numeric_limits<std::size_t>::max)();
+
+  return event{
+    [=](auto...){return detail::callback<value_type>(detail::stateful(
+      sides_type{},
+      [=](auto& sides,auto& sig,auto index,const auto& x){
+        auto now=timed?clock::now():clock::time_point{};
+        if(bounded){
+          std::apply([&](auto&... s){(s.expire(w,now),...);},sides);
+        }
+
+        const key_type& k=f(x);
+        pointers_type   ps;
+        std::get<index.value>(ps)=&x;
+        detail::join_emit<0,index.value>(sides,k,ps,sig);
+
+        auto& s=std::get<index.value>(sides);
+        s.insert(k,x,now);
+        if(bounded)s.expire(w,now);
+      }
+    ));},
+    srcs...
+  };
+}
+
+template<
+  typename F,typename Src,typename... Srcs,
+  std::enable_if_t<!std::is_same_v<std::decay_t<Src>,join_window>>* =nullptr
+>
+auto join_by(F f,Src& src,Srcs&... srcs)
+{
+  return join_by(f,join_window{},src,srcs...);
+}
+
+template<typename Pred>
+auto filter(Pred pred)
+{
+  return detail::type_passthrough(
+    [=](auto& sig,auto,auto&& x){
+      if(pred(std::as_const(x)))sig(std::forward<decltype(x)>(x));});
+}
+
+template<typename F>
+auto map(F f)
+{
+  return [=](auto... args){
+    return detail::callback<std::common_type_t<decltype(f(args.get()))>...>(
+      [=](auto& sig,auto,auto&& x){
+        /* rvalues only go to callables that can take them */
+
+        if constexpr(std::is_invocable_v<const F&,decltype(x)>){
+          sig(f(std::forward<decltype(x)>(x)));
+        }
+        else sig(f(std::as_const(x)));
+      });
+  };
+}
+
+template<typename T,typename BynaryOp>
+auto accumulate(T init,BynaryOp op)
+{
+  return [=](auto...){return detail::callback<T>(detail::stateful(
+    init,
+    [=](T& res,auto& sig,auto,auto&& x){
+      if constexpr(std::is_invocable_v<const BynaryOp&,T,decltype(x)>){
+        res=op(std::move(res),std::forward<decltype(x)>(x));
+      }
+      else res=op(std::move(res),std::as_const(x));
+      sig(res);
+    }
+  ));};
+}
+
+/* keeps the n first values in comp order, emits only when they change */
+
+template<typename Compare=std::less<>>
+auto top_k(std::size_t n,Compare comp=Compare{})
+{
+  return [=](auto... args){
+    using value_type=
+      std::vector<std::common_type_t<std::decay_t<decltype(args.get())>...>>;
+
+    return detail::callback<value_type>(detail::stateful(
+      value_type{},
+      [=](value_type& res,auto& sig,auto,auto&& x){
+        if(res.size()==n&&(n==0||!comp(x,res.back())))return;
+        res.insert(
+          std::upper_bound(res.begin(),res.end(),x,comp),
+          std::forward<decltype(x)>(x));
+        if(res.size()>n)res.pop_back();
+        sig(res);
+      }
+    ));
+  };
+}
+
+namespace detail{
+
+/* DDSketch-style quantile estimation: values are mapped to logarithmic
+ * buckets with relative accuracy rel_err (negatives mirrored, magnitudes
+ * below min_value pooled at key 0) and, once more than max_bins buckets
+ * are spanned, the lowest ones are collapsed. A cursor on the bucket
+ * holding the requested rank makes insertion O(1) amortized.
+ */
+
+class quantile_sketch
+{
+public:
+  static constexpr double min_value=1e-9;
+
+  quantile_sketch(double q,double rel_err,std::size_t max_bins):
+    q{q},gamma{(1+rel_err)/(1-rel_err)},inv_log_gamma{1/std::log(gamma)},
+    min_index{static_cast<long>(std::ceil(std::log(min_value)*inv_log_gamma))},
+    max_bins{max_bins<1?1:max_bins}{}
+
+  /* returns whether the estimate changed */
+
+  bool insert(double x)
+  {
+    add(key(x));
+    auto r=static_cast<std::uint64_t>(q*static_cast<double>(n-1));
+    while(r<below){
+      do --cur;while(!count(cur));
+      below-=count(cur);
+    }
+    while(r>=below+count(cur)){
+      below+=count(cur);
+      do ++cur;while(!count(cur));
+    }
+    if(cur==last)return false;
+    last=cur;
+    return true;
+  }
+
+  double value()const
+  {
+    if(cur==0)return 0.0;
+    auto v=2*std::pow(gamma,static_cast<double>(std::abs(cur)-1+min_index))/
+      (gamma+1);
+    return cur>0?v:-v;
+  }
+
+  void save(snapshot_writer& w)const{w<<counts<<offset<<n<<cur<<below<<last;}
+  void load(snapshot_reader& r){r>>counts>>offset>>n>>cur>>below>>last;}
+
+private:
+  long key(double x)const
+  {
+    auto a=std::abs(x);
+    if(!(a>min_value))return 0;
+    auto i=static_cast<long>(std::ceil(std::log(a)*inv_log_gamma))-
+      min_index+1;
+    return x>0?i:-i;
+  }
+
+  std::uint64_t count(long k)const
+  {
+    return counts[static_cast<std::size_t>(k-offset)];
+  }
+
+  void add(long k)
+  {
+    auto size=static_cast<long>(counts.size());
+    if(counts.empty()){
+      counts.push_back(0);
+      offset=cur=k;
+    }
+    else if(k<offset){
+      if(offset+size-k>static_cast<long>(max_bins))k=offset;
+      else{
+        counts.insert(counts.begin(),static_cast<std::size_t>(offset-k),0);
+        offset=k;
+      }
+    }
+    else if(k>=offset+size){
+      counts.resize(static_cast<std::size_t>(k-offset+1),0);
+      if(counts.size()>max_bins)collapse(counts.size()-max_bins);
+    }
+    if(k<cur)++below;
+    ++counts[static_cast<std::size_t>(k-offset)];
+    ++n;
+  }
+
+  void collapse(std::size_t m)
+  {
+    for(std::size_t i=0;i<m;++i)counts[m]+=counts[i];
+    counts.erase(counts.begin(),counts.begin()+m);
+    offset+=static_cast<long>(m);
+    if(cur<=offset){
+      cur=offset;
+      below=0;
+    }
+  }
+
+  double                     q,gamma,inv_log_gamma;
+  long                       min_index;
+  std::size_t                max_bins;
+  std::vector<std::uint64_t> counts;
+  long                       offset=0;
+  std::uint64_t              n=0;
+  long                       cur=0;
+  std::uint64_t              below=0;
+  long                       last=(std::numeric_limits<long>::min)();
+};
+
+} /* namespace detail */
+
+/* approximate q-quantile (q in [0,1]) within relative error rel_err (in
+ * (0,1)) using bounded memory, emits only when the estimate changes
+ */
+
+inline auto quantile(double q,double rel_err=0.01,std::size_t max_bins=2048)
+{
+  if(!(q>=0.0&&q<=1.0))throw std::invalid_argument{"q must be in [0,1]"};
+  if(!(rel_err>0.0&&rel_err<1.0)){
+    throw std::invalid_argument{"rel_err must be in (0,1)"};
+  }
+
+  return [=](auto...){return detail::callback<double>(detail::stateful(
+    detail::quantile_sketch{q,rel_err,max_bins},
+    [](detail::quantile_sketch& s,auto& sig,auto,auto x){
+      if(s.insert(static_cast<double>(x)))sig(s.value());
+    }
+  ));};
+}
+
+inline auto distinct_until_changed()
+{
+  return [](auto... args){
+    using value_type=std::common_type_t<std::decay_t<decltype(args.get())>...>;
+
+    return detail::callback<value_type>(detail::stateful(
+      std::optional<value_type>{},
+      [](std::optional<value_type>& last,auto& sig,auto,auto&& x){
+        if(last&&*last==x)return;
+        last=x;
+        sig(std::forward<decltype(x)>(x));
+      }
+    ));
+  };
+}
+
+namespace detail{
+
+inline std::uint64_t mix_hash(std::uint64_t h)
+{
+  h^=h>>33;
+  h*=0xff51afd7ed558ccdull;
+  h^=h>>33;
+  h*=0xc4ceb9fe1a85ec53ull;
+  h^=h>>33;
+  return h;
+}
+
+/* Remembers the last capacity distinct values: linear probing over a
+ * power-of-two table at most half full, whose slots point into a ring of
+ * values in insertion order. Once full, the oldest value is dropped
+ * (backward shift deletion) and its ring position reused, so insertion
+ * never allocates.
+ */
+
+template<typename T>
+class fifo_hash_set
+{
+public:
+  explicit fifo_hash_set(std::size_t capacity):
+    capacity{capacity<1?1:capacity}
+  {
+    std::size_t n=2;
+    while(n<2*this->capacity)n<<=1;
+    slots.resize(n);
+    mask=n-1;
+    ring.reserve(this->capacity);
+  }
+
+  /* returns false if x was already present */
+
+  bool insert(const T& x)
+  {
+    auto h=hash(x);
+    auto i=find(x,h);
+    if(slots[i].pos!=empty)return false;
+    if(ring.size()<capacity){
+      slots[i]={static_cast<std::uint32_t>(ring.size()),h};
+      ring.push_back(x);
+    }
+    else{
+      erase(ring[head]);
+      ring[head]=x;
+      slots[find(x,h)]={static_cast<std::uint32_t>(head),h};
+      head=(head+1)%capacity;
+    }
+    return true;
+  }
+
+  void save(snapshot_writer& w)const{w<<ring<<head;}
+
+  void load(snapshot_reader& r)
+  {
+    r>>ring>>head;
+    if(ring.size()>capacity){
+      throw std::runtime_error{"snapshot does not match graph structure"};
+    }
+    std::fill(slots.begin(),slots.end(),slot{});
+    for(std::size_t pos=0;pos<ring.size();++pos){
+      auto h=hash(ring[pos]);
+      slots[find(ring[pos],h)]={static_cast<std::uint32_t>(pos),h};
+    }
+  }
+
+private:
+  static constexpr std::uint32_t empty=
+    (std::numeric_limits<std::uint32_t>::max)();
+
+  struct slot
+  {
+    std::uint32_t pos=empty;
+    std::uint32_t h=0;
+  };
+
+  static std::uint32_t hash(const T& x)
+  {
+    return static_cast<std::uint32_t>(mix_hash(boost::hash<T>{}(x)));
+  }
+
+  /* slot holding x or, if absent, the empty slot ending its probe */
+
+  std::size_t find(const T& x,std::uint32_t h)const
+  {
+    auto i=h&mask;
+    while(slots[i].pos!=empty&&
+          !(slots[i].h==h&&ring[slots[i].pos]==x))i=(i+1)&mask;
+    return i;
+  }
+
+  void erase(const T& x)
+  {
+    auto i=find(x,hash(x));
+    for(auto j=(i+1)&mask;slots[j].pos!=empty;j=(j+1)&mask){
+      auto home=slots[j].h&mask;
+      if(((j-home)&mask)>=((j-i)&mask)){
+        slots[i]=slots[j];
+        i=j;
+      }
+    }
+    slots[i]=slot{};
+  }
+
+  std::size_t       capacity,mask,head=0;
+  std::vector<slot> slots;
+  std::vector<T>    ring;
+};
+
+/* Two Bloom filter generations, each sized for capacity values at half
+ * the target false positive rate: values are looked up in both and
+ * inserted in the current one, which becomes the previous one once it
+ * holds capacity values. At least the last capacity distinct values are
+ * remembered, in constant memory.
+ */
+
+class generational_bloom_filter
+{
+public:
+  generational_bloom_filter(std::size_t capacity,double fp_rate):
+    capacity{capacity<1?1:capacity}
+  {
+    auto ln2=std::log(2.0);
+    bits=static_cast<std::size_t>(std::ceil(
+      -static_cast<double>(this->capacity)*std::log(fp_rate/2)/(ln2*ln2)));
+    if(bits<64)bits=64;
+    k=static_cast<std::size_t>(std::lround(
+      static_cast<double>(bits)/static_cast<double>(this->capacity)*ln2));
+    if(k<1)k=1;
+    cur.resize((bits+63)/64);
+    prev.resize(cur.size());
+  }
+
+  /* returns false if h was (probably) already inserted */
+
+  bool insert(std::uint64_t h)
+  {
+    h=mix_hash(h);
+    if(contains(cur,h)||contains(prev,h))return false;
+    if(count==capacity){
+      prev.swap(cur);
+      std::fill(cur.begin(),cur.end(),0);
+      count=0;
+    }
+    for_each_bit(h,[&](std::size_t b){cur[b/64]|=std::uint64_t(1)<<(b%64);});
+    ++count;
+    return true;
+  }
+
+  void save(snapshot_writer& w)const{w<<cur<<prev<<count;}
+
+  void load(snapshot_reader& r)
+  {
+    auto n=cur.size();
+    r>>cur>>prev>>count;
+    if(cur.size()!=n||prev.size()!=n){
+      throw std::runtime_error{"snapshot does not match graph structure"};
+    }
+  }
+
+private:
+  template<typename F>
+  void for_each_bit(std::uint64_t h,F f)const
+  {
+    auto h2=(h>>32)|1;
+    for(std::size_t i=0;i<k;++i)f(static_cast<std::size_t>((h+i*h2)%bits));
+  }
+
+  bool contains(const std::vector<std::uint64_t>& v,std::uint64_t h)const
+  {
+    bool res=true;
+    for_each_bit(h,[&](std::size_t b){
+      res=res&&(v[b/64]>>(b%64)&1);
+    });
+    return res;
+  }
+
+  std::size_t                capacity,bits,k,count=0;
+  std::vector<std::uint64_t> cur,prev;
+};
+
+} /* namespace detail */
+
+/* drops values seen among the last capacity distinct ones (capacity must
+ * fit in 32 bits)
+ */
+
+inline auto distinct(std::size_t capacity)
+{
+  if(capacity>(std::numeric_limits<std::uint32_t>::max)()){
+    throw std::invalid_argument{"distinct capacity too large"};
+  }
+
+  return [=](auto... args){
+    using value_type=std::common_type_t<std::decay_t<decltype(args.get())>...>;
+
+    return detail::callback<value_type>(detail::stateful(
+      detail::fifo_hash_set<value_type>{capacity},
+      [](auto& seen,auto& sig,auto,auto&& x){
+        if(seen.insert(x))sig(std::forward<decltype(x)>(x));
+      }
+    ));
+  };
+}
+
+/* as distinct, in constant memory, but new values are mistaken for
+ * repeated ones with probability at most fp_rate, in (0,1)
+ */
+
+inline auto distinct_approx(std::size_t capacity,double fp_rate=0.01)
+{
+  if(!(fp_rate>0.0&&fp_rate<1.0)){
+    throw std::invalid_argument{"fp_rate must be in (0,1)"};
+  }
+
+  return [=](auto... args){
+    using value_type=std::common_type_t<std::decay_t<decltype(args.get())>...>;
+
+    return detail::callback<value_type>(detail::stateful(
+      detail::generational_bloom_filter{capacity,fp_rate},
+      [](auto& seen,auto& sig,auto,auto&& x){
+        if(seen.insert(boost::hash<value_type>{}(x))){
+          sig(std::forward<decltype(x)>(x));
+        }
+      }
+    ));
+  };
+}
+
+namespace detail{
+
+/* snapshots keep the keys in order of appearance; loading re-emits the
+ * per-key events so that downstream structure is rebuilt before its state
+ * is loaded
+ */
+
+template<typename F,typename Key,typename Trigger>
+class group_by_callback
+{
+public:
+  group_by_callback(F f):f{f}{}
+
+  template<typename Sig,typename Index,typename Arg>
+  void operator()(Sig& sig,Index,Arg&& x)
+  {
+    auto it=find(f(std::as_const(x)),sig);
+    it->second=std::forward<Arg>(x);
+  }
+
+  void save(snapshot_writer& w)const{w<<keys;}
+
+  template<typename Sig>
+  void load(snapshot_reader& r,Sig& sig)
+  {
+    std::vector<Key> ks;
+    r>>ks;
+    for(const auto& k:ks)find(k,sig);
+  }
+
+private:
+  template<typename Sig>
+  auto find(const Key& k,Sig& sig)
+  {
+    auto [it,b]=trgs.try_emplace(k);
+    if(b){
+      keys.push_back(k);
+      sig(merge(it->second));
+    }
+    return it;
+  }
+
+  F                                 f;
+  std::unordered_map<Key,Trigger>   trgs;
+  std::vector<Key>                  keys;
+};
+
+} /* namespace detail */
+
+template<typename F>
+auto group_by(F f)
+{
+  return [=](auto... args){
+    using arg_type=std::common_type_t<decltype(args.get())...>;
+    using key_type=std::common_type_t<decltype(f(args.get()))...>;
+    using trigger_type=trigger<arg_type>;
+    using value_type=decltype(merge(std::declval<trigger_type&>()));
       
     return detail::callback<value_type>(
-      [=,trgs=std::unordered_map<key_type,trigger_type>{}]
-      (auto& sig,auto,const auto& x)mutable{
-        const auto& k=f(x);
-        auto        [it,b]=trgs.try_emplace(k);
-        if(b)sig(merge(it->second));
-        it->second=x;
-      }
-    );
+      detail::group_by_callback<F,key_type,trigger_type>{f});
   };
 }
     
@@ -881,15 +2531,343 @@ auto collect()
     using element_type=std::common_type_t<decltype(args.get())...>;
     using value_type=std::vector<element_type>;
 
-    return detail::callback<value_type>(
-      [v=value_type{}](auto& sig,auto,const auto& x)mutable{
-        v.push_back(x);
+    return detail::callback<value_type>(detail::stateful(
+      value_type{},
+      [](auto& v,auto& sig,auto,auto&& x){
+        v.push_back(std::forward<decltype(x)>(x));
         sig(v);
       }
+    ));
+  };
+}
+
+/* Incremental containers: vector_value and map_value signal one change
+ * per mutation rather than their whole contents, and the delta operators
+ * keep their results up to date from those changes. Loading a container
+ * from a snapshot signals no changes, as downstream delta operators
+ * restore their own state from the same snapshot.
+ */
+
+enum class change_kind{insert,erase,update};
+
+template<typename Key,typename T>
+struct change
+{
+  using key_type=Key;
+  using mapped_type=T;
+
+  change_kind      kind;
+  Key              key;
+  std::optional<T> old_value,new_value;
+};
+
+template<typename T>
+class vector_value:public detail::node<
+  vector_value<T>,
+  void(const vector_value<T>&,const change<std::size_t,T>&)
+>
+{
+  using super=detail::node<
+    vector_value,void(const vector_value&,const change<std::size_t,T>&)>;
+
+public:
+  using container_type=std::vector<T>;
+  using value_type=change<std::size_t,T>;
+
+  vector_value()=default;
+  vector_value(const vector_value&)=default;
+  vector_value(vector_value&&)=default;
+
+  vector_value& operator=(const vector_value&)=default;
+  vector_value& operator=(vector_value&&)=default;
+
+  void swap(vector_value& x)
+  {
+    using std::swap;
+    base().swap(x.base());
+    swap(c,x.c);
+  }
+
+  const container_type& get()const noexcept{return c;}
+  std::size_t           size()const noexcept{return c.size();}
+  const T&              operator[](std::size_t pos)const{return c[pos];}
+
+  void push_back(T x){insert(c.size(),std::move(x));}
+
+  void insert(std::size_t pos,T x)
+  {
+    c.insert(c.begin()+pos,std::move(x));
+    publish({change_kind::insert,pos,std::nullopt,c[pos]});
+  }
+
+  void erase(std::size_t pos)
+  {
+    T old=std::move(c[pos]);
+    c.erase(c.begin()+pos);
+    publish({change_kind::erase,pos,std::move(old),std::nullopt});
+  }
+
+  void set(std::size_t pos,T x)
+  {
+    if(!(c[pos]==x)){
+      T old=std::exchange(c[pos],std::move(x));
+      publish({change_kind::update,pos,std::move(old),c[pos]});
+    }
+  }
+    
+  void save(snapshot_writer& w)const{w<<c;}
+  void load(snapshot_reader& r){r>>c;}
+    
+  template<typename Slot>
+  auto operator|(Slot s)&{return event{s,*this};}
+
+private:
+  super& base()noexcept{return *this;}
+
+  void publish(value_type&& x){this->signal_rvalue(*this,std::move(x));}
+
+  container_type c;
+};
+
+template<typename T>
+void swap(vector_value<T>& x,vector_value<T>& y){x.swap(y);}
+
+template<typename Key,typename T>
+class map_value:public detail::node<
+  map_value<Key,T>,
+  void(const map_value<Key,T>&,const change<Key,T>&)
+>
+{
+  using super=detail::node<
+    map_value,void(const map_value&,const change<Key,T>&)>;
+
+public:
+  using container_type=std::map<Key,T>;
+  using value_type=change<Key,T>;
+
+  map_value()=default;
+  map_value(const map_value&)=default;
+  map_value(map_value&&)=default;
+
+  map_value& operator=(const map_value&)=default;
+  map_value& operator=(map_value&&)=default;
+
+  void swap(map_value& x)
+  {
+    using std::swap;
+    base().swap(x.base());
+    swap(c,x.c);
+  }
+
+  const container_type& get()const noexcept{return c;}
+  std::size_t           size()const noexcept{return c.size();}
+
+  const T* find(const Key& k)const
+  {
+    auto it=c.find(k);
+    return it!=c.end()?&it->second:nullptr;
+  }
+
+  void insert_or_assign(const Key& k,T x)
+  {
+    auto [it,b]=c.try_emplace(k,x);
+    if(b){
+      publish({change_kind::insert,k,std::nullopt,std::move(x)});
+    }
+    else if(!(it->second==x)){
+      T old=std::exchange(it->second,x);
+      publish({change_kind::update,k,std::move(old),std::move(x)});
+    }
+  }
+
+  void erase(const Key& k)
+  {
+    if(auto it=c.find(k);it!=c.end()){
+      T old=std::move(it->second);
+      c.erase(it);
+      publish({change_kind::erase,k,std::move(old),std::nullopt});
+    }
+  }
+    
+  void save(snapshot_writer& w)const{w<<c;}
+  void load(snapshot_reader& r){r>>c;}
+    
+  template<typename Slot>
+  auto operator|(Slot s)&{return event{s,*this};}
+
+private:
+  super& base()noexcept{return *this;}
+
+  void publish(value_type&& x){this->signal_rvalue(*this,std::move(x));}
+
+  container_type c;
+};
+
+template<typename Key,typename T>
+void swap(map_value<Key,T>& x,map_value<Key,T>& y){x.swap(y);}
+
+/* incremental operators on change streams: each change is processed in
+ * constant time regardless of the size of the originating container.
+ * Positions reported by views over vector_value refer to the source vector.
+ */
+
+template<typename F>
+auto delta_map(F f)
+{
+  return [=](auto... args){
+    using change_type=std::common_type_t<decltype(args.get())...>;
+    using key_type=typename change_type::key_type;
+    using mapped_type=std::decay_t<
+      decltype(f(std::declval<typename change_type::mapped_type>()))>;
+    using value_type=change<key_type,mapped_type>;
+
+    return detail::callback<value_type>(
+      [=](auto& sig,auto,const auto& x){
+        auto g=[&](const auto& o){
+          return o?std::optional<mapped_type>{f(*o)}:std::nullopt;};
+        sig(value_type{x.kind,x.key,g(x.old_value),g(x.new_value)});
+      }
     );
   };
 }
 
+template<typename Pred>
+auto delta_filter(Pred pred)
+{
+  return detail::type_passthrough(
+    [=](auto& sig,auto,auto&& x){
+      bool old_in=x.old_value&&pred(*x.old_value),
+           new_in=x.new_value&&pred(*x.new_value);
+      if(old_in&&new_in){
+        sig(std::forward<decltype(x)>(x));
+      }
+      else if(old_in){
+        auto y=std::forward<decltype(x)>(x);
+        y.kind=change_kind::erase;
+        y.new_value.reset();
+        sig(std::move(y));
+      }
+      else if(new_in){
+        auto y=std::forward<decltype(x)>(x);
+        y.kind=change_kind::insert;
+        y.old_value.reset();
+        sig(std::move(y));
+      }
+    });
+}
+
+inline auto delta_sum()
+{
+  return [=](auto... args){
+    using change_type=std::common_type_t<decltype(args.get())...>;
+    using value_type=typename change_type::mapped_type;
+
+    return detail::callback<value_type>(detail::stateful(
+      value_type{},
+      [](auto& res,auto& sig,auto,const auto& x){
+        if(x.old_value)res=std::move(res)-*x.old_value;
+        if(x.new_value)res=std::move(res)+*x.new_value;
+        sig(res);
+      }
+    ));
+  };
+}
+
+inline auto delta_count()
+{
+  return [=](auto...){
+    return detail::callback<std::size_t>(detail::stateful(
+      std::size_t(0),
+      [](std::size_t& n,auto& sig,auto,const auto& x){
+        if(x.kind==change_kind::insert)sig(++n);
+        else if(x.kind==change_kind::erase)sig(--n);
+      }
+    ));
+  };
+}
+
+namespace detail{
+
+/* per-key states in order of key appearance, with keys and states kept in
+ * separate columns behind a single hash index
+ */
+
+template<typename Key,typename T>
+class keyed_store
+{
+public:
+  /* returns the index of k's state, inserting init if absent */
+
+  std::pair<std::size_t,bool> find_or_insert(const Key& k,const T& init)
+  {
+    auto [it,b]=index.try_emplace(k,states.size());
+    if(b){
+      keys.push_back(k);
+      states.push_back(init);
+    }
+    return {it->second,b};
+  }
+
+  T& state(std::size_t i){return states[i];}
+
+  void save(snapshot_writer& w)const{w<<keys<<states;}
+
+  void load(snapshot_reader& r)
+  {
+    r>>keys>>states;
+    if(keys.size()!=states.size()){
+      throw std::runtime_error{"snapshot does not match graph structure"};
+    }
+    index.clear();
+    for(std::size_t i=0;i<keys.size();++i)index.emplace(keys[i],i);
+  }
+
+private:
+  std::unordered_map<Key,std::size_t,boost::hash<Key>> index;
+  std::vector<Key>                                     keys;
+  std::vector<T>                                       states;
+};
+
+} /* namespace detail */
+
+/* folds values into per-key states with op, starting from init, and emits
+ * the resulting insert/update change for the key
+ */
+
+template<typename KeyFn,typename T,typename BinaryOp>
+auto aggregate_by(KeyFn key_fn,T init,BinaryOp op)
+{
+  return [=](auto... args){
+    using key_type=
+      std::decay_t<std::common_type_t<decltype(key_fn(args.get()))...>>;
+    using value_type=change<key_type,T>;
+
+    return detail::callback<value_type>(detail::stateful(
+      detail::keyed_store<key_type,T>{},
+      [=](auto& store,auto& sig,auto,auto&& x){
+        auto  k=key_fn(std::as_const(x));
+        auto  [i,inserted]=store.find_or_insert(k,init);
+        auto& st=store.state(i);
+        auto  fold=[&]{
+          if constexpr(std::is_invocable_v<const BinaryOp&,T,decltype(x)>){
+            st=op(std::move(st),std::forward<decltype(x)>(x));
+          }
+          else st=op(std::move(st),std::as_const(x));
+        };
+        if(inserted){
+          fold();
+          sig(value_type{change_kind::insert,std::move(k),std::nullopt,st});
+        }
+        else{
+          std::optional<T> old=st;
+          fold();
+          sig(value_type{change_kind::update,std::move(k),std::move(old),st});
+        }
+      }
+    ));
+  };
+}
+
 } /* namespace usingstdcpp2019::urp */
 
 #endif
@@ -0,0 +1,538 @@
+/* Some fun with Reactive Programming in C++17.
+ *
+ * Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+
+#ifndef USINGSTDCPP2019_URP_DYNAMIC_HPP
+#define USINGSTDCPP2019_URP_DYNAMIC_HPP
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#include <algorithm>
+#include <any>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/* Runtime counterpart of urp.hpp: topologies are assembled node by node
+ * (typically from configuration) rather than encoded in types. Payloads
+ * are type-erased in any_value, callables in small_function, and the graph
+ * keeps its edges in flat arrays.
+ */
+
+namespace usingstdcpp2019::urp::dynamic{
+
+template<typename Signature,std::size_t Capacity=4*sizeof(void*)>
+class small_function;
+
+template<typename R,typename... Args,std::size_t Capacity>
+class small_function<R(Args...),Capacity>
+{
+public:
+  small_function()=default;
+  template<
+    typename F,
+    std::enable_if_t<!std::is_same_v<std::decay_t<F>,small_function>>* =
+      nullptr
+  >
+  small_function(F f)
+  {
+    if constexpr(fits<F>){
+      ::new (static_cast<void*>(buf)) F{std::move(f)};
+      vt=&inline_vtable<F>;
+    }
+    else{
+      ::new (static_cast<void*>(buf)) F*{new F{std::move(f)}};
+      vt=&heap_vtable<F>;
+    }
+  }
+  small_function(const small_function& x):vt{x.vt}{if(vt)vt->copy(x.buf,buf);}
+  small_function(small_function&& x)noexcept:vt{x.vt}
+  {
+    if(vt){
+      vt->move(x.buf,buf);
+      x.vt=nullptr;
+    }
+  }
+  ~small_function(){if(vt)vt->destroy(buf);}
+
+  small_function& operator=(small_function x)noexcept
+  {
+    if(vt)vt->destroy(buf);
+    vt=x.vt;
+    if(vt){
+      vt->move(x.buf,buf);
+      x.vt=nullptr;
+    }
+    return *this;
+  }
+
+  explicit operator bool()const noexcept{return vt;}
+
+  R operator()(Args... args)
+  {
+    return vt->invoke(buf,std::forward<Args>(args)...);
+  }
+
+private:
+  struct vtable
+  {
+    R    (*invoke)(void*,Args&&...);
+    void (*copy)(const void*,void*);
+    void (*move)(void*,void*)noexcept;
+    void (*destroy)(void*)noexcept;
+  };
+
+  template<typename F>
+  static constexpr bool fits=
+    sizeof(F)<=Capacity&&alignof(F)<=alignof(std::max_align_t)&&
+    std::is_nothrow_move_constructible_v<F>;
+
+  template<typename F>
+  static constexpr vtable inline_vtable={
+    [](void* p,Args&&... args)->R{
+      return (*static_cast<F*>(p))(std::forward<Args>(args)...);},
+    [](const void* p,void* q){
+      ::new (q) F{*static_cast<const F*>(p)};},
+    [](void* p,void* q)noexcept{
+      ::new (q) F{std::move(*static_cast<F*>(p))};
+      static_cast<F*>(p)->~F();},
+    [](void* p)noexcept{static_cast<F*>(p)->~F();}
+  };
+
+  template<typename F>
+  static constexpr vtable heap_vtable={
+    [](void* p,Args&&... args)->R{
+      return (**static_cast<F**>(p))(std::forward<Args>(args)...);},
+    [](const void* p,void* q){
+      ::new (q) F*{new F{**static_cast<F* const*>(p)}};},
+    [](void* p,void* q)noexcept{
+      ::new (q) F*{*static_cast<F**>(p)};},
+    [](void* p)noexcept{delete *static_cast<F**>(p);}
+  };
+
+  alignas(std::max_align_t) unsigned char buf[Capacity];
+  const vtable*                           vt=nullptr;
+};
+
+namespace detail{
+
+template<typename T,typename=void>
+struct is_equality_comparable:std::false_type{};
+template<typename T>
+struct is_equality_comparable<
+  T,std::void_t<decltype(std::declval<const T&>()==std::declval<const T&>())>
+>:std::true_type{};
+
+} /* namespace detail */
+
+class any_value
+{
+public:
+  any_value()=default;
+  template<
+    typename T,
+    std::enable_if_t<!std::is_same_v<std::decay_t<T>,any_value>>* =nullptr
+  >
+  any_value(T&& x):a{std::forward<T>(x)},eq{&equal<std::decay_t<T>>}{}
+
+  bool has_value()const noexcept{return a.has_value();}
+  const std::type_info& type()const noexcept{return a.type();}
+
+  template<typename T>
+  const T& get()const
+  {
+    if(auto p=std::any_cast<T>(&a))return *p;
+    throw std::bad_any_cast{};
+  }
+
+  bool operator==(const any_value& x)const
+  {
+    return eq==x.eq&&(!eq||eq(a,x.a));
+  }
+  bool operator!=(const any_value& x)const{return !(*this==x);}
+
+private:
+  template<typename T>
+  static bool equal(const std::any& x,const std::any& y)
+  {
+    if constexpr(detail::is_equality_comparable<T>::value){
+      return *std::any_cast<T>(&x)==*std::any_cast<T>(&y);
+    }
+    else return false; /* always propagate */
+  }
+
+  std::any a;
+  bool     (*eq)(const std::any&,const std::any&)=nullptr;
+};
+
+using node_id=std::uint32_t;
+
+class graph;
+
+class arguments
+{
+public:
+  arguments(const graph& g,const node_id* first,std::size_t n):
+    g{g},first{first},n{n}{}
+
+  std::size_t size()const noexcept{return n;}
+  inline const any_value& operator[](std::size_t i)const;
+
+  template<typename T>
+  const T& get(std::size_t i)const{return (*this)[i].get<T>();}
+
+private:
+  const graph&   g;
+  const node_id* first;
+  std::size_t    n;
+};
+
+class emitter
+{
+public:
+  emitter(graph& g,node_id id):g{g},id{id}{}
+
+  inline void operator()(const any_value& x)const;
+
+private:
+  graph&  g;
+  node_id id;
+};
+
+using function_type=small_function<any_value(const arguments&)>;
+using reaction_type=
+  small_function<void(const emitter&,std::size_t,const any_value&)>;
+using observer_type=small_function<void(const any_value&)>;
+
+/* named prototypes for the callables a configuration can refer to */
+
+class registry
+{
+public:
+  void define_function(const std::string& op,function_type f)
+  {
+    functions.insert_or_assign(op,std::move(f));
+  }
+
+  void define_reaction(const std::string& op,reaction_type r)
+  {
+    reactions.insert_or_assign(op,std::move(r));
+  }
+
+  const function_type& function(const std::string& op)const
+  {
+    return find(functions,op);
+  }
+
+  const reaction_type& reaction(const std::string& op)const
+  {
+    return find(reactions,op);
+  }
+
+private:
+  template<typename Map>
+  static const typename Map::mapped_type& find(
+    const Map& m,const std::string& op)
+  {
+    auto it=m.find(op);
+    if(it==m.end())throw std::out_of_range{"unknown operation "+op};
+    return it->second;
+  }
+
+  std::unordered_map<std::string,function_type> functions;
+  std::unordered_map<std::string,reaction_type> reactions;
+};
+
+class graph
+{
+public:
+  graph()=default;
+  explicit graph(const registry& reg):reg{&reg}{}
+  graph(const graph&)=delete;
+
+  graph& operator=(const graph&)=delete;
+
+  std::size_t size()const noexcept{return nodes.size();}
+
+  node_id find(const std::string& name)const
+  {
+    auto it=names.find(name);
+    if(it==names.end())throw std::out_of_range{"unknown node "+name};
+    return it->second;
+  }
+
+  node_id add_value(const std::string& name,any_value v)
+  {
+    return add_node(name,kind::value,std::move(v),0,{});
+  }
+
+  node_id add_trigger(const std::string& name)
+  {
+    return add_node(name,kind::trigger,{},0,{});
+  }
+
+  node_id add_function(
+    const std::string& name,function_type f,std::vector<node_id> args)
+  {
+    for(auto id:args)check(id,{kind::value,kind::function,kind::hold});
+    functions.push_back(std::move(f));
+    auto id=add_node(
+      name,kind::function,{},node_id(functions.size()-1),std::move(args));
+    auto& n=nodes[id];
+    n.v=functions[n.callable](
+      arguments{*this,inputs.data()+n.first_input,n.arity});
+    return id;
+  }
+
+  node_id add_event(
+    const std::string& name,reaction_type r,std::vector<node_id> srcs)
+  {
+    for(auto id:srcs)check(id,{kind::trigger,kind::event});
+    reactions.push_back(std::move(r));
+    return add_node(
+      name,kind::event,{},node_id(reactions.size()-1),std::move(srcs));
+  }
+
+  node_id add_hold(const std::string& name,node_id src,any_value init)
+  {
+    check(src,{kind::trigger,kind::event});
+    return add_node(name,kind::hold,std::move(init),0,{src});
+  }
+
+  /* registry-based construction, all nodes referred to by name */
+
+  node_id add_function(
+    const std::string& name,const std::string& op,
+    std::initializer_list<std::string> args)
+  {
+    return add_function(name,get_registry().function(op),ids(args));
+  }
+
+  node_id add_event(
+    const std::string& name,const std::string& op,
+    std::initializer_list<std::string> srcs)
+  {
+    return add_event(name,get_registry().reaction(op),ids(srcs));
+  }
+
+  void connect(node_id id,observer_type o)
+  {
+    observers.push_back({id,std::move(o)});
+    topology_changed=true;
+  }
+
+  const any_value& get(node_id id)const{return nodes[id].v;}
+
+  template<typename T>
+  const T& get(node_id id)const{return nodes[id].v.get<T>();}
+
+  void set(node_id id,any_value v)
+  {
+    check(id,{kind::value});
+    update(id,std::move(v));
+  }
+
+  void fire(node_id id,const any_value& x)
+  {
+    check(id,{kind::trigger});
+    emit(id,x);
+  }
+
+private:
+  friend class arguments;
+  friend class emitter;
+
+  enum class kind:std::uint8_t{value,function,trigger,event,hold};
+
+  struct node
+  {
+    kind      k;
+    any_value v;
+    node_id   callable;
+    node_id   first_input,arity;
+    node_id   first_succ=0,num_succs=0;
+    node_id   first_observer=0,num_observers=0;
+    bool      queued=false;
+  };
+
+  struct edge
+  {
+    node_id dst,index;
+  };
+
+  const registry& get_registry()const
+  {
+    if(!reg)throw std::logic_error{"graph has no registry"};
+    return *reg;
+  }
+
+  std::vector<node_id> ids(std::initializer_list<std::string> names)const
+  {
+    std::vector<node_id> res;
+    for(const auto& name:names)res.push_back(find(name));
+    return res;
+  }
+
+  void check(node_id id,std::initializer_list<kind> ks)const
+  {
+    if(id>=nodes.size()||
+       std::find(ks.begin(),ks.end(),nodes[id].k)==ks.end()){
+      throw std::invalid_argument{"invalid node"};
+    }
+  }
+
+  node_id add_node(
+    const std::string& name,kind k,any_value v,node_id callable,
+    std::vector<node_id> srcs)
+  {
+    auto id=node_id(nodes.size());
+    if(!name.empty()&&!names.emplace(name,id).second){
+      throw std::invalid_argument{"duplicate node "+name};
+    }
+    nodes.push_back(
+      {k,std::move(v),callable,node_id(inputs.size()),node_id(srcs.size())});
+    inputs.insert(inputs.end(),srcs.begin(),srcs.end());
+    topology_changed=true;
+    return id;
+  }
+
+  /* successors and observers of each node are laid out contiguously,
+   * rebuilt lazily after the topology changes
+   */
+
+  void build_adjacency()
+  {
+    if(!topology_changed)return;
+
+    for(auto& n:nodes)n.num_succs=n.num_observers=0;
+    for(const auto& n:nodes){
+      for(node_id i=0;i<n.arity;++i)++nodes[inputs[n.first_input+i]].num_succs;
+    }
+    std::stable_sort(
+      observers.begin(),observers.end(),
+      [](const auto& x,const auto& y){return x.first<y.first;});
+    for(const auto& [id,o]:observers)++nodes[id].num_observers;
+    node_id s=0,o=0;
+    for(auto& n:nodes){
+      n.first_succ=s;
+      n.first_observer=o;
+      s+=n.num_succs;
+      o+=n.num_observers;
+      n.num_succs=0;
+    }
+
+    succs.resize(s);
+    for(node_id id=0;id<nodes.size();++id){
+      const auto& n=nodes[id];
+      for(node_id i=0;i<n.arity;++i){
+        auto& src=nodes[inputs[n.first_input+i]];
+        succs[src.first_succ+src.num_succs++]={id,i};
+      }
+    }
+    topology_changed=false;
+  }
+
+  void notify(node_id id)
+  {
+    const auto& n=nodes[id];
+    for(node_id i=0;i<n.num_observers;++i){
+      observers[n.first_observer+i].second(n.v);
+    }
+  }
+
+  /* continuous nodes: ids are created in topological order, so pending
+   * recomputations are served lowest id first
+   */
+
+  void update(node_id id,any_value v)
+  {
+    if(nodes[id].v==v)return;
+    build_adjacency();
+    nodes[id].v=std::move(v);
+    changed(id);
+    while(!pending.empty()){
+      std::pop_heap(pending.begin(),pending.end(),std::greater<>{});
+      auto  next=pending.back();
+      auto& n=nodes[next];
+      pending.pop_back();
+      n.queued=false;
+      auto u=functions[n.callable](
+        arguments{*this,inputs.data()+n.first_input,n.arity});
+      if(!(u==n.v)){
+        n.v=std::move(u);
+        changed(next);
+      }
+    }
+  }
+
+  void changed(node_id id)
+  {
+    notify(id);
+    const auto& n=nodes[id];
+    for(node_id i=0;i<n.num_succs;++i){
+      auto& m=nodes[succs[n.first_succ+i].dst];
+      if(!m.queued){
+        m.queued=true;
+        pending.push_back(succs[n.first_succ+i].dst);
+        std::push_heap(pending.begin(),pending.end(),std::greater<>{});
+      }
+    }
+  }
+
+  /* discrete nodes: depth-first push, as with urp::event */
+
+  void emit(node_id id,const any_value& x)
+  {
+    build_adjacency();
+    const auto& n=nodes[id];
+    for(node_id i=0;i<n.num_observers;++i){
+      observers[n.first_observer+i].second(x);
+    }
+    for(node_id i=0;i<n.num_succs;++i){
+      auto [dst,index]=succs[n.first_succ+i];
+      auto& m=nodes[dst];
+      if(m.k==kind::event){
+        reactions[m.callable](emitter{*this,dst},index,x);
+      }
+      else update(dst,x); /* hold */
+    }
+  }
+
+  const registry*                                reg=nullptr;
+  std::vector<node>                              nodes;
+  std::vector<node_id>                           inputs;
+  std::vector<edge>                              succs;
+  std::vector<function_type>                     functions;
+  std::vector<reaction_type>                     reactions;
+  std::vector<std::pair<node_id,observer_type>>  observers;
+  std::vector<node_id>                           pending;
+  std::unordered_map<std::string,node_id>        names;
+  bool                                           topology_changed=true;
+};
+
+const any_value& arguments::operator[](std::size_t i)const
+{
+  return g.get(first[i]);
+}
+
+void emitter::operator()(const any_value& x)const{g.emit(id,x);}
+
+} /* namespace usingstdcpp2019::urp::dynamic */
+
+#endif
@@ -0,0 +1,284 @@
+/* Some fun with Reactive Programming in C++17.
+ *
+ * Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+
+#ifndef USINGSTDCPP2019_URP_FILE_HPP
+#define USINGSTDCPP2019_URP_FILE_HPP
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/signals2/connection.hpp>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "urp.hpp"
+
+namespace usingstdcpp2019::urp{
+
+namespace detail{
+
+/* record file layout: header (magic, record size) padded to the alignment
+ * of T, followed by the raw object representations of the recorded values.
+ */
+
+inline constexpr char record_magic[8]={'u','r','p','r','e','c','0','1'};
+
+template<typename T>
+inline constexpr std::size_t record_header_size=
+  alignof(T)>16?alignof(T):16;
+
+} /* namespace detail */
+
+template<typename T>
+class recorder
+{
+  static_assert(
+    std::is_trivially_copyable_v<T>,
+    "only trivially copyable values can be recorded");
+
+public:
+  using value_type=T;
+
+  template<typename Src>
+  recorder(Src& src,const std::string& path,std::size_t buffer_size=1<<16):
+    os{path,std::ios::binary|std::ios::trunc}
+  {
+    if(!os)throw std::runtime_error{"cannot open "+path};
+
+    char          header[detail::record_header_size<T>]={};
+    std::uint32_t record_size=sizeof(T);
+    std::memcpy(header,detail::record_magic,sizeof(detail::record_magic));
+    std::memcpy(
+      header+sizeof(detail::record_magic),&record_size,sizeof(record_size));
+    os.write(header,sizeof(header));
+    if(!os)throw std::runtime_error{"cannot write to "+path};
+
+    buf.reserve(buffer_size<sizeof(T)?sizeof(T):buffer_size);
+    conn=src.connect([this](const auto&,const T& x){write(x);});
+  }
+  recorder(const recorder&)=delete;
+  ~recorder()
+  {
+    conn.disconnect();
+    try{flush();}catch(...){}
+  }
+
+  recorder& operator=(const recorder&)=delete;
+
+  std::uint64_t size()const noexcept{return n;}
+
+  /* throws if the buffered records can't be written out; the destructor
+   * flushes too, but silently, so call flush() first to learn about
+   * failures at the end of a recording
+   */
+
+  void flush()
+  {
+    os.write(buf.data(),buf.size());
+    os.flush();
+    buf.clear();
+    if(!os)throw std::runtime_error{"failed to write recorded values"};
+  }
+
+private:
+  void write(const T& x)
+  {
+    if(buf.capacity()-buf.size()<sizeof(T))flush();
+    auto p=reinterpret_cast<const char*>(&x);
+    buf.insert(buf.end(),p,p+sizeof(T));
+    ++n;
+  }
+
+  std::ofstream                         os;
+  std::vector<char>                     buf;
+  std::uint64_t                         n=0;
+  boost::signals2::scoped_connection    conn;
+};
+
+template<typename Src>
+recorder(Src&,const std::string&)->recorder<typename Src::value_type>;
+template<typename Src>
+recorder(Src&,const std::string&,std::size_t)->
+  recorder<typename Src::value_type>;
+
+template<typename T>
+class replayer
+{
+  static_assert(
+    std::is_trivially_copyable_v<T>,
+    "only trivially copyable values can be replayed");
+
+public:
+  using value_type=T;
+
+  /* an empty file is taken as an empty stream */
+
+  explicit replayer(const std::string& path)
+  {
+    if(!std::filesystem::is_regular_file(path)){
+      throw std::runtime_error{"cannot open "+path};
+    }
+    if(std::filesystem::file_size(path)==0)return; /* can't map 0 bytes */
+    mapping=boost::interprocess::file_mapping{
+      path.c_str(),boost::interprocess::read_only};
+    region=boost::interprocess::mapped_region{
+      mapping,boost::interprocess::read_only};
+
+    auto          p=static_cast<const char*>(region.get_address());
+    std::size_t   s=region.get_size();
+    std::uint32_t record_size=0;
+    if(s>=detail::record_header_size<T>){
+      std::memcpy(
+        &record_size,p+sizeof(detail::record_magic),sizeof(record_size));
+    }
+    if(s<detail::record_header_size<T>||
+       std::memcmp(p,detail::record_magic,sizeof(detail::record_magic))!=0||
+       record_size!=sizeof(T)){
+      throw std::runtime_error{path+" is not a record file for this type"};
+    }
+    region.advise(boost::interprocess::mapped_region::advice_sequential);
+    first=p+detail::record_header_size<T>;
+    n=(s-detail::record_header_size<T>)/sizeof(T);
+  }
+
+  std::size_t size()const noexcept{return n;}
+  std::size_t position()const noexcept{return pos;}
+  bool        done()const noexcept{return pos==n;}
+  void        rewind()noexcept{pos=0;}
+
+  /* injects up to max_records values into trg, returns the number injected */
+
+  std::size_t replay(
+    trigger<T>& trg,
+    std::size_t max_records=(std::numeric_limits<std::size_t>::max)())
+  {
+    std::size_t m=n-pos<max_records?n-pos:max_records;
+    auto        p=first+pos*sizeof(T);
+    for(std::size_t i=0;i<m;++i,p+=sizeof(T)){
+      /* the mapping is page aligned and the header padded to alignof(T),
+       * so records are read in place, with no intermediate copy
+       */
+
+      trg=*std::launder(reinterpret_cast<const T*>(p));
+    }
+    pos+=m;
+    return m;
+  }
+
+private:
+  boost::interprocess::file_mapping  mapping;
+  boost::interprocess::mapped_region region;
+  const char*                        first=nullptr;
+  std::size_t                        n=0,pos=0;
+};
+
+/* Splits a memory-mapped text file into lines (without the delimiter nor
+ * a trailing '\r') injected as std::string_view's pointing into the
+ * mapping: the views, and anything downstream holding them, are valid as
+ * long as the line_reader lives.
+ */
+
+class line_reader
+{
+public:
+  using value_type=std::string_view;
+
+  explicit line_reader(const std::string& path,char delimiter='\n'):
+    delimiter{delimiter}
+  {
+    if(!std::filesystem::is_regular_file(path)){
+      throw std::runtime_error{"cannot open "+path};
+    }
+    if(std::filesystem::file_size(path)==0)return; /* can't map 0 bytes */
+    mapping=boost::interprocess::file_mapping{
+      path.c_str(),boost::interprocess::read_only};
+    region=boost::interprocess::mapped_region{
+      mapping,boost::interprocess::read_only};
+    region.advise(boost::interprocess::mapped_region::advice_sequential);
+    first=static_cast<const char*>(region.get_address());
+    last=first+region.get_size();
+    pos=first;
+  }
+
+  std::size_t size()const noexcept{return std::size_t(last-first);}
+  std::size_t position()const noexcept{return std::size_t(pos-first);}
+  bool        done()const noexcept{return pos==last;}
+  void        rewind()noexcept{pos=first;}
+
+  /* injects up to max_lines lines into trg, returns the number injected */
+
+  std::size_t replay(
+    trigger<std::string_view>& trg,
+    std::size_t max_lines=(std::numeric_limits<std::size_t>::max)())
+  {
+    std::size_t n=0;
+    for(;n<max_lines&&!done();++n)trg=next();
+    return n;
+  }
+
+  /* injects up to max_lines lines in batches of up to batch_size (which
+   * can't be zero); the batch vector is reused, so steady-state dispatch
+   * doesn't allocate
+   */
+
+  std::size_t replay(
+    trigger<std::vector<std::string_view>>& trg,std::size_t batch_size,
+    std::size_t max_lines=(std::numeric_limits<std::size_t>::max)())
+  {
+    if(batch_size==0)throw std::invalid_argument{"batch_size must be positive"};
+
+    std::size_t n=0;
+    batch.reserve(batch_size);
+    while(n<max_lines&&!done()){
+      batch.clear();
+      while(batch.size()<batch_size&&n<max_lines&&!done()){
+        batch.push_back(next());
+        ++n;
+      }
+      trg=batch;
+    }
+    return n;
+  }
+
+private:
+  std::string_view next()
+  {
+    auto p=static_cast<const char*>(
+      std::memchr(pos,delimiter,std::size_t(last-pos)));
+    auto end=p?p:last;
+    std::string_view line{pos,std::size_t(end-pos)};
+    pos=p?p+1:last;
+    if(!line.empty()&&line.back()=='\r')line.remove_suffix(1);
+    return line;
+  }
+
+  char                               delimiter;
+  boost::interprocess::file_mapping  mapping;
+  boost::interprocess::mapped_region region;
+  const char*                        first=nullptr;
+  const char*                        last=nullptr;
+  const char*                        pos=nullptr;
+  std::vector<std::string_view>      batch;
+};
+
+} /* namespace usingstdcpp2019::urp */
+
+#endif
@@ -0,0 +1,255 @@
+/* Some fun with Reactive Programming in C++17.
+ *
+ * Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+
+#ifndef USINGSTDCPP2019_URP_FOOTPRINT_HPP
+#define USINGSTDCPP2019_URP_FOOTPRINT_HPP
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/* Memory footprint accounting. Heap figures need the global allocation
+ * functions to be replaced with counting ones, which is done by defining
+ * USINGSTDCPP2019_URP_FOOTPRINT_ALLOCATOR in exactly one translation unit
+ * before including this header; otherwise only object sizes are reported.
+ *
+ * Accounting is by explicit tracking, not by walking a graph: a category
+ * is whatever the code run by track() builds, and totals only cover
+ * tracked regions. Heap counters are process-wide, so allocations made by
+ * other threads while a region runs are charged to it too: track with no
+ * other thread allocating.
+ */
+
+namespace usingstdcpp2019::urp{
+
+namespace detail{
+
+struct heap_counters
+{
+  std::atomic<std::int64_t>  live_bytes{0};
+  std::atomic<std::uint64_t> allocations{0};
+  bool                       enabled=false;
+};
+
+inline heap_counters& heap()
+{
+  static heap_counters c;
+  return c;
+}
+
+} /* namespace detail */
+
+class footprint
+{
+public:
+  struct entry
+  {
+    std::string   category;
+    std::size_t   objects=0;
+    std::size_t   object_bytes=0;
+    std::int64_t  heap_bytes=0;
+    std::uint64_t allocations=0;
+  };
+
+  static bool heap_accounting(){return detail::heap().enabled;}
+
+  /* runs f and charges category with the heap bytes it left allocated and
+   * the allocations it made (process-wide, see above), plus the size of
+   * the object it returns, if any
+   */
+
+  template<typename F>
+  decltype(auto) track(std::string_view category,F f)
+  {
+    auto& h=detail::heap();
+    auto  b0=h.live_bytes.load(std::memory_order_relaxed);
+    auto  a0=h.allocations.load(std::memory_order_relaxed);
+    auto  charge=[&](std::size_t objects,std::size_t object_bytes){
+      auto  b1=h.live_bytes.load(std::memory_order_relaxed);
+      auto  a1=h.allocations.load(std::memory_order_relaxed);
+      auto& e=find(category);
+      e.objects+=objects;
+      e.object_bytes+=object_bytes;
+      e.heap_bytes+=b1-b0;
+      e.allocations+=a1-a0;
+    };
+
+    using result_type=decltype(f());
+    if constexpr(std::is_void_v<result_type>){
+      f();
+      charge(0,0);
+    }
+    else{
+      result_type res=f();
+      charge(1,sizeof(std::remove_reference_t<result_type>));
+      return res;
+    }
+  }
+
+  const std::vector<entry>& entries()const noexcept{return es;}
+
+  entry total()const
+  {
+    entry t{"total"};
+    for(const auto& e:es){
+      t.objects+=e.objects;
+      t.object_bytes+=e.object_bytes;
+      t.heap_bytes+=e.heap_bytes;
+      t.allocations+=e.allocations;
+    }
+    return t;
+  }
+
+  /* one row per category with per-object figures, then the totals */
+
+  friend std::ostream& operator<<(std::ostream& os,const footprint& fp)
+  {
+    auto row=[&](const entry& e,double div){
+      os<<std::left<<std::setw(28)<<e.category<<std::right
+        <<std::setw(9)<<e.objects<<std::setw(11)<<e.object_bytes/div;
+      if(heap_accounting()){
+        os<<std::setw(11)<<e.heap_bytes/div<<std::setw(11)<<e.allocations/div;
+      }
+      else os<<std::setw(11)<<"n/a"<<std::setw(11)<<"n/a";
+      os<<"\n";
+    };
+
+    os<<std::left<<std::setw(28)<<"category"<<std::right
+      <<std::setw(9)<<"objects"<<std::setw(11)<<"sizeof"
+      <<std::setw(11)<<"heap"<<std::setw(11)<<"allocs"<<"\n";
+    for(const auto& e:fp.es)row(e,e.objects?double(e.objects):1.0);
+    row(fp.total(),1.0);
+    return os;
+  }
+
+private:
+  entry& find(std::string_view category)
+  {
+    for(auto& e:es)if(e.category==category)return e;
+    es.push_back(entry{std::string{category}});
+    return es.back();
+  }
+
+  std::vector<entry> es;
+};
+
+} /* namespace usingstdcpp2019::urp */
+
+#if defined(USINGSTDCPP2019_URP_FOOTPRINT_ALLOCATOR)
+
+#include <cstdlib>
+#include <new>
+
+/* each block is prefixed with its size so that frees can be accounted;
+ * over-aligned blocks get a prefix as large as their alignment, with the
+ * size stored right before the user pointer as in ordinary blocks
+ */
+
+namespace usingstdcpp2019::urp::detail{
+
+inline constexpr std::size_t heap_prefix=alignof(std::max_align_t);
+
+static const bool heap_hooked=(heap().enabled=true);
+
+inline void* heap_allocate(std::size_t n,std::size_t al)
+{
+  auto prefix=al>heap_prefix?al:heap_prefix;
+  auto p=static_cast<char*>(
+    al>heap_prefix?
+      std::aligned_alloc(al,(n+prefix+al-1)/al*al):
+      std::malloc(n+prefix));
+  if(!p)throw std::bad_alloc{};
+  p+=prefix;
+  *reinterpret_cast<std::size_t*>(p-heap_prefix)=n;
+  auto& h=heap();
+  h.live_bytes.fetch_add(std::int64_t(n),std::memory_order_relaxed);
+  h.allocations.fetch_add(1,std::memory_order_relaxed);
+  return p;
+}
+
+inline void heap_deallocate(void* p,std::size_t al)noexcept
+{
+  if(!p)return;
+  auto q=static_cast<char*>(p);
+  heap().live_bytes.fetch_sub(
+    std::int64_t(*reinterpret_cast<std::size_t*>(q-heap_prefix)),
+    std::memory_order_relaxed);
+  std::free(q-(al>heap_prefix?al:heap_prefix));
+}
+
+} /* namespace usingstdcpp2019::urp::detail */
+
+void* operator new(std::size_t n)
+{
+  return usingstdcpp2019::urp::detail::heap_allocate(n,0);
+}
+
+void* operator new[](std::size_t n)
+{
+  return usingstdcpp2019::urp::detail::heap_allocate(n,0);
+}
+
+void* operator new(std::size_t n,std::align_val_t al)
+{
+  return usingstdcpp2019::urp::detail::heap_allocate(n,std::size_t(al));
+}
+
+void* operator new[](std::size_t n,std::align_val_t al)
+{
+  return usingstdcpp2019::urp::detail::heap_allocate(n,std::size_t(al));
+}
+
+void operator delete(void* p)noexcept
+{
+  usingstdcpp2019::urp::detail::heap_deallocate(p,0);
+}
+
+void operator delete[](void* p)noexcept
+{
+  usingstdcpp2019::urp::detail::heap_deallocate(p,0);
+}
+
+void operator delete(void* p,std::align_val_t al)noexcept
+{
+  usingstdcpp2019::urp::detail::heap_deallocate(p,std::size_t(al));
+}
+
+void operator delete[](void* p,std::align_val_t al)noexcept
+{
+  usingstdcpp2019::urp::detail::heap_deallocate(p,std::size_t(al));
+}
+
+void operator delete(void* p,std::size_t)noexcept{::operator delete(p);}
+void operator delete[](void* p,std::size_t)noexcept{::operator delete[](p);}
+
+void operator delete(void* p,std::size_t,std::align_val_t al)noexcept
+{
+  ::operator delete(p,al);
+}
+
+void operator delete[](void* p,std::size_t,std::align_val_t al)noexcept
+{
+  ::operator delete[](p,al);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,315 @@
+/* Some fun with Reactive Programming in C++17.
+ *
+ * Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+
+#ifndef USINGSTDCPP2019_URP_PROFILE_HPP
+#define USINGSTDCPP2019_URP_PROFILE_HPP
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <boost/core/demangle.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "urp.hpp"
+
+/* Propagation profiler. Between profiler::enable() and disable(), every
+ * propagation records its causal tree: the node that signals with no
+ * propagation under way is the root, and each node callback run on its
+ * behalf is a frame under the frame of the node that signalled it. Frames
+ * are aggregated by path into a calling context tree with call counts and
+ * inclusive times, kept per thread: enabling applies to all threads, but
+ * labels, reset() and the exports only concern the calling thread, so
+ * shards must label and export their nodes from tasks run on them.
+ */
+
+namespace usingstdcpp2019::urp{
+
+namespace detail{
+
+class profile_tree
+{
+public:
+  static constexpr std::size_t none=std::size_t(-1);
+
+  struct frame
+  {
+    std::size_t              node,parent;
+    std::vector<std::size_t> children={};
+    std::uint64_t            calls=0,ns=0; /* ns is inclusive */
+  };
+
+  bool active()const noexcept{return cur!=0;}
+
+  void enter(const void* addr,const std::type_info& ti)
+  {
+    cur=child(cur,node_id(addr,ti));
+    ++frames[cur].calls;
+    starts.push_back(clock::now());
+  }
+
+  void exit()
+  {
+    frames[cur].ns+=std::uint64_t(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        clock::now()-starts.back()).count());
+    starts.pop_back();
+    cur=frames[cur].parent;
+  }
+
+  void label(const void* addr,const std::type_info& ti,std::string name)
+  {
+    names[node_id(addr,ti)]=std::move(name);
+  }
+
+  void reset()
+  {
+    frames.resize(1);
+    frames[0].children.clear();
+    cur=0;
+    starts.clear();
+  }
+
+  const std::vector<frame>&       tree()const noexcept{return frames;}
+  const std::vector<std::string>& node_names()const noexcept{return names;}
+
+private:
+  using clock=std::chrono::steady_clock;
+
+  /* nodes are told apart by address and type, as a destroyed node's
+   * address can be reused for a node of some other kind
+   */
+
+  std::size_t node_id(const void* addr,const std::type_info& ti)
+  {
+    auto& ids=ids_by_addr[addr];
+    for(auto id:ids)if(*types[id]==ti)return id;
+    auto id=names.size();
+    ids.push_back(id);
+    types.push_back(&ti);
+    names.push_back(kind(ti)+"#"+std::to_string(id));
+    return id;
+  }
+
+  /* usingstdcpp2019::urp::function<...> -> function */
+
+  static std::string kind(const std::type_info& ti)
+  {
+    auto str=boost::core::demangle(ti.name());
+    str=str.substr(0,str.find('<'));
+    auto pos=str.rfind("::");
+    return pos==std::string::npos?str:str.substr(pos+2);
+  }
+
+  std::size_t child(std::size_t parent,std::size_t node)
+  {
+    for(auto i:frames[parent].children)if(frames[i].node==node)return i;
+    frames.push_back(frame{node,parent});
+    frames[parent].children.push_back(frames.size()-1);
+    return frames.size()-1;
+  }
+
+  using id_map=std::unordered_map<const void*,std::vector<std::size_t>>;
+
+  std::vector<frame>                 frames={frame{none,none}};
+  std::size_t                        cur=0;
+  std::vector<clock::time_point>     starts;
+  id_map                             ids_by_addr;
+  std::vector<const std::type_info*> types;
+  std::vector<std::string>           names;
+};
+
+inline profile_tree& profile()
+{
+  static thread_local profile_tree t;
+  return t;
+}
+
+inline const profile_hooks profile_tree_hooks={
+  [](const void* addr,const std::type_info& ti){profile().enter(addr,ti);},
+  []{profile().exit();},
+  []{return profile().active();}
+};
+
+} /* namespace detail */
+
+class profiler
+{
+public:
+  struct step
+  {
+    std::string   node;
+    std::uint64_t calls;
+    double        ns; /* inclusive */
+  };
+
+  /* safe while shards propagate on other threads, but not to be called
+   * from within a propagation
+   */
+
+  static void enable()
+  {
+    detail::profiling.store(
+      &detail::profile_tree_hooks,std::memory_order_relaxed);
+  }
+
+  static void disable()
+  {
+    detail::profiling.store(nullptr,std::memory_order_relaxed);
+  }
+
+  static bool enabled()
+  {
+    return detail::profiling.load(std::memory_order_relaxed)!=nullptr;
+  }
+
+  /* names a node in the exports, instead of kind#id */
+
+  template<typename Node>
+  static void label(const Node& n,std::string name)
+  {
+    detail::profile().label(&n,typeid(Node),std::move(name));
+  }
+
+  static void reset(){detail::profile().reset();}
+
+  /* heaviest root, then heaviest child at every level */
+
+  static std::vector<step> critical_path()
+  {
+    const auto&       t=detail::profile().tree();
+    std::vector<step> res;
+    for(auto i=heaviest(t[0].children);i!=none;i=heaviest(t[i].children)){
+      res.push_back({name(t[i].node),t[i].calls,double(t[i].ns)});
+    }
+    return res;
+  }
+
+  /* one line per path with its self time in ns, as taken by flame graph
+   * tools
+   */
+
+  static void write_folded(std::ostream& os)
+  {
+    const auto& t=detail::profile().tree();
+    for(auto i:t[0].children)write_folded(os,i,name(t[i].node));
+  }
+
+  /* nodes with their self and inclusive times, edges from signalling to
+   * signalled node with the calls and inclusive time of the latter under
+   * the former; the critical path is drawn in red
+   */
+
+  static void write_dot(std::ostream& os)
+  {
+    const auto& t=detail::profile().tree();
+    const auto& names=detail::profile().node_names();
+
+    struct totals{std::uint64_t calls=0,self=0,ns=0;};
+    using edge=std::pair<std::size_t,std::size_t>;
+
+    std::vector<totals>   nodes(names.size());
+    std::map<edge,totals> edges;
+    std::vector<bool>     seen(names.size());
+    std::vector<edge>     critical;
+    for(auto i=heaviest(t[0].children);i!=none;i=heaviest(t[i].children)){
+      if(t[i].parent!=0)critical.push_back({t[t[i].parent].node,t[i].node});
+    }
+
+    /* inclusive times are only summed up for the outermost frame of a
+     * node in each path, so that cycles aren't counted twice
+     */
+
+    auto visit=[&](auto& visit,std::size_t i)->void{
+      const auto& f=t[i];
+      auto        self=f.ns;
+      for(auto j:f.children)self-=t[j].ns;
+      auto& n=nodes[f.node];
+      n.calls+=f.calls;
+      n.self+=self;
+      bool outermost=!seen[f.node];
+      if(outermost){
+        n.ns+=f.ns;
+        seen[f.node]=true;
+      }
+      if(f.parent!=0){
+        auto& e=edges[{t[f.parent].node,f.node}];
+        e.calls+=f.calls;
+        e.ns+=f.ns;
+      }
+      for(auto j:f.children)visit(visit,j);
+      if(outermost)seen[f.node]=false;
+    };
+    for(auto i:t[0].children)visit(visit,i);
+
+    os<<"digraph urp{\n"
+      <<"  node[shape=box,fontname=\"monospace\"];\n";
+    for(std::size_t k=0;k<names.size();++k){
+      if(!nodes[k].calls)continue;
+      os<<"  n"<<k<<"[label=\""<<names[k]
+        <<"\\n"<<nodes[k].calls<<" calls"
+        <<"\\nself "<<us(nodes[k].self)<<" us"
+        <<"\\ntotal "<<us(nodes[k].ns)<<" us\"];\n";
+    }
+    for(const auto& [ft,e]:edges){
+      os<<"  n"<<ft.first<<"->n"<<ft.second<<"[label=\""<<e.calls<<" / "
+        <<us(e.ns)<<" us\"";
+      if(std::find(critical.begin(),critical.end(),ft)!=critical.end()){
+        os<<",color=red,penwidth=2";
+      }
+      os<<"];\n";
+    }
+    os<<"}\n";
+  }
+
+private:
+  static constexpr std::size_t none=detail::profile_tree::none;
+
+  static std::string name(std::size_t node)
+  {
+    return detail::profile().node_names()[node];
+  }
+
+  static double us(std::uint64_t ns){return double(ns)/1000.0;}
+
+  static std::size_t heaviest(const std::vector<std::size_t>& frames)
+  {
+    const auto& t=detail::profile().tree();
+    std::size_t res=none;
+    for(auto i:frames)if(res==none||t[i].ns>t[res].ns)res=i;
+    return res;
+  }
+
+  static void write_folded(
+    std::ostream& os,std::size_t i,const std::string& path)
+  {
+    const auto& t=detail::profile().tree();
+    auto        self=t[i].ns;
+    for(auto j:t[i].children){
+      self-=t[j].ns;
+      write_folded(os,j,path+";"+name(t[j].node));
+    }
+    os<<path<<" "<<self<<"\n";
+  }
+};
+
+} /* namespace usingstdcpp2019::urp */
+
+#endif
@@ -0,0 +1,165 @@
+/* Some fun with Reactive Programming in C++17.
+ *
+ * Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+
+#ifndef USINGSTDCPP2019_URP_SCHEDULER_HPP
+#define USINGSTDCPP2019_URP_SCHEDULER_HPP
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#include <boost/signals2/connection.hpp>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "urp.hpp"
+
+namespace usingstdcpp2019::urp{
+
+/* Cooperative propagation scheduler: work is posted as tasks to priority
+ * lanes (lane 0 first) and run one at a time, always from the highest
+ * priority non-empty lane. Cascades are split into tasks at deferred
+ * edges, which is where a low priority cascade yields to pending high
+ * priority work. Nodes themselves carry no priority: a cascade runs to
+ * completion between deferred edges, so long chains (a big collect or
+ * group_by, say) need deferred edges placed by hand to be preemptible.
+ */
+
+struct lane_stats
+{
+  std::uint64_t tasks=0;
+  double        p50=0.0,p99=0.0,max=0.0; /* post to completion, in ns */
+};
+
+class scheduler
+{
+public:
+  explicit scheduler(std::size_t num_lanes=2):lanes(num_lanes)
+  {
+    if(num_lanes==0)throw std::invalid_argument{"scheduler needs a lane"};
+  }
+
+  std::size_t num_lanes()const noexcept{return lanes.size();}
+
+  template<typename F>
+  void post(std::size_t lane,F f)
+  {
+    lanes.at(lane).tasks.push_back({std::move(f),clock::now()});
+  }
+
+  bool empty()const noexcept
+  {
+    for(const auto& l:lanes)if(!l.tasks.empty())return false;
+    return true;
+  }
+
+  /* runs the oldest task of the highest priority lane, if any */
+
+  bool run_one()
+  {
+    for(auto& l:lanes){
+      if(l.tasks.empty())continue;
+      auto t=std::move(l.tasks.front());
+      l.tasks.pop_front();
+      t.f();
+      l.record(std::chrono::duration<double,std::nano>(
+        clock::now()-t.posted).count());
+      return true;
+    }
+    return false;
+  }
+
+  std::size_t run()
+  {
+    std::size_t n=0;
+    while(run_one())++n;
+    return n;
+  }
+
+  lane_stats stats(std::size_t lane)const
+  {
+    const auto& l=lanes.at(lane);
+    lane_stats  res;
+    res.tasks=l.n;
+    if(l.n){
+      res.p50=l.p50.value();
+      res.p99=l.p99.value();
+      res.max=l.max;
+    }
+    return res;
+  }
+
+private:
+  using clock=std::chrono::steady_clock;
+
+  struct task
+  {
+    std::function<void()> f;
+    clock::time_point     posted;
+  };
+
+  struct lane
+  {
+    void record(double latency)
+    {
+      ++n;
+      p50.insert(latency);
+      p99.insert(latency);
+      if(latency>max)max=latency;
+    }
+
+    std::deque<task>        tasks;
+    std::uint64_t           n=0;
+    detail::quantile_sketch p50{0.5,0.01,2048},p99{0.99,0.01,2048};
+    double                  max=0.0;
+  };
+
+  std::vector<lane> lanes;
+};
+
+/* Deferred edge: values from src are assigned to dst in a task posted to
+ * the given lane instead of propagating right away.
+ */
+
+template<typename T>
+class deferred
+{
+public:
+  using value_type=T;
+
+  template<typename Src>
+  deferred(scheduler& sch,std::size_t lane,Src& src,trigger<T>& dst)
+  {
+    if(lane>=sch.num_lanes())throw std::out_of_range{"no such lane"};
+
+    /* the task takes the one copy needed, then moves it into dst */
+
+    conn=src.connect([&sch,lane,&dst](const auto&,const auto& x){
+      sch.post(lane,[&dst,y=T(x)]()mutable{dst=std::move(y);});
+    });
+  }
+  deferred(const deferred&)=delete;
+
+  deferred& operator=(const deferred&)=delete;
+
+private:
+  boost::signals2::scoped_connection conn;
+};
+
+template<typename Src,typename T>
+deferred(scheduler&,std::size_t,Src&,trigger<T>&)->deferred<T>;
+
+} /* namespace usingstdcpp2019::urp */
+
+#endif
@@ -0,0 +1,213 @@
+/* Some fun with Reactive Programming in C++17.
+ *
+ * Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+
+#ifndef USINGSTDCPP2019_URP_SHARD_HPP
+#define USINGSTDCPP2019_URP_SHARD_HPP
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <boost/lockfree/spsc_queue.hpp>
+#include <boost/signals2/connection.hpp>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "urp.hpp"
+
+namespace usingstdcpp2019::urp{
+
+/* A shard is a worker thread owning a subgraph: nodes placed on a shard
+ * must only be built, read and updated from tasks run on it (execute/post),
+ * so propagation inside a shard stays single-threaded. Shards talk to
+ * each other through channels only.
+ */
+
+namespace detail{
+
+struct inbound_channel
+{
+  virtual ~inbound_channel()=default;
+  virtual void drain()=0;
+};
+
+} /* namespace detail */
+
+template<typename T> class channel;
+
+class shard
+{
+public:
+  shard():worker{[this]{run();}}{}
+  shard(const shard&)=delete;
+  ~shard()
+  {
+    {
+      std::lock_guard lck{mtx};
+      stopping=true;
+    }
+    cv.notify_one();
+    worker.join();
+  }
+
+  shard& operator=(const shard&)=delete;
+
+  /* runs f on the shard thread and waits for its result; a shard can't
+   * wait on another (the other could be waiting on it), so this throws
+   * std::logic_error if called from a task running on a different shard
+   */
+
+  template<typename F>
+  auto execute(F f)
+  {
+    if(std::this_thread::get_id()==worker.get_id())return f();
+    if(current()){
+      throw std::logic_error{"nested cross-shard execute can deadlock"};
+    }
+
+    auto task=std::make_shared<std::packaged_task<std::invoke_result_t<F&>()>>(
+      std::move(f));
+    auto res=task->get_future();
+    post([=]{(*task)();});
+    return res.get();
+  }
+
+  template<typename F>
+  void post(F f)
+  {
+    {
+      std::lock_guard lck{mtx};
+      tasks.emplace_back(std::move(f));
+    }
+    wake();
+  }
+
+private:
+  template<typename> friend class channel;
+
+  static shard*& current()noexcept
+  {
+    static thread_local shard* p=nullptr;
+    return p;
+  }
+
+  /* the mutex is only taken to sleep and wake up: a busy producer finds the
+   * shard already flagged and just pushes into its channel
+   */
+
+  void wake()
+  {
+    if(!ready.exchange(true,std::memory_order_acq_rel)){
+      std::lock_guard lck{mtx};
+      cv.notify_one();
+    }
+  }
+
+  void run()
+  {
+    std::vector<std::function<void()>> batch;
+    current()=this;
+    for(bool stop=false;!stop;){
+      {
+        std::unique_lock lck{mtx};
+        cv.wait(lck,[this]{
+          return ready.load(std::memory_order_acquire)||stopping;});
+        ready.exchange(false,std::memory_order_acq_rel);
+        batch.swap(tasks);
+        stop=stopping;
+      }
+
+      /* values pushed before a task was posted are delivered before it runs */
+
+      for(auto ch:inbound)ch->drain();
+      for(auto& f:batch)f();
+      batch.clear();
+    }
+  }
+
+  std::mutex                               mtx;
+  std::condition_variable                  cv;
+  std::vector<std::function<void()>>       tasks;
+  bool                                     stopping=false;
+  std::atomic<bool>                        ready=false;
+  std::vector<detail::inbound_channel*>    inbound;
+  std::thread                              worker;
+};
+
+/* Cross-shard edge: values from src (living on shard from) are queued and
+ * assigned to dst (living on shard to). A full queue blocks the producer
+ * until the consumer catches up, so channels must not form cycles, the
+ * shortest one being a channel from a shard to itself, which is rejected.
+ */
+
+template<typename T>
+class channel:detail::inbound_channel
+{
+public:
+  using value_type=T;
+
+  template<typename Src>
+  channel(
+    shard& from,Src& src,shard& to,trigger<T>& dst,std::size_t capacity=1024):
+    from{from},to{to},dst{dst},q{capacity}
+  {
+    if(&from==&to){
+      throw std::invalid_argument{"channel must link two different shards"};
+    }
+    to.execute([this]{this->to.inbound.push_back(this);});
+    conn=from.execute([&]{
+      return src.connect([this](const auto&,const auto& x){push(x);});
+    });
+  }
+  channel(const channel&)=delete;
+  ~channel()
+  {
+    from.execute([this]{conn.disconnect();});
+    to.execute([this]{
+      drain();
+      auto& v=this->to.inbound;
+      v.erase(std::find(
+        v.begin(),v.end(),static_cast<detail::inbound_channel*>(this)));
+    });
+  }
+
+  channel& operator=(const channel&)=delete;
+
+private:
+  void push(const T& x)
+  {
+    while(!q.push(x))std::this_thread::yield();
+    to.wake();
+  }
+
+  void drain()override
+  {
+    q.consume_all([this](T& x){dst=std::move(x);});
+  }
+
+  shard&                         from;
+  shard&                         to;
+  trigger<T>&                    dst;
+  boost::lockfree::spsc_queue<T> q;
+  boost::signals2::connection    conn;
+};
+
+} /* namespace usingstdcpp2019::urp */
+
+#endif
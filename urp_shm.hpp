@@ -0,0 +1,226 @@
+/* Some fun with Reactive Programming in C++17.
+ *
+ * Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+
+#ifndef USINGSTDCPP2019_URP_SHM_HPP
+#define USINGSTDCPP2019_URP_SHM_HPP
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include "urp.hpp"
+
+namespace usingstdcpp2019::urp{
+
+namespace detail{
+
+/* Single-producer single-consumer ring in a shared memory segment: header
+ * with the free-running write (head) and read (tail) indices on separate
+ * cache lines, followed by a power-of-two number of slots. The magic word
+ * is stored last, with release semantics, so that a subscriber seeing it
+ * sees the rest of the header too.
+ */
+
+inline constexpr std::uint64_t shm_magic=0x31306d6873707275; /* "urpshm01" */
+
+struct shm_ring_header
+{
+  std::atomic<std::uint64_t>             magic;
+  std::uint32_t                          record_size;
+  std::uint32_t                          capacity;
+  alignas(64) std::atomic<std::uint64_t> head;
+  alignas(64) std::atomic<std::uint64_t> tail;
+};
+
+static_assert(
+  std::atomic<std::uint64_t>::is_always_lock_free,
+  "shared memory rings need address-free atomics");
+
+template<typename T>
+inline constexpr std::size_t shm_slots_offset=
+  (sizeof(shm_ring_header)+alignof(T)-1)/alignof(T)*alignof(T);
+
+inline std::uint32_t shm_capacity(std::size_t n)
+{
+  if(n>(std::uint32_t(1)<<31)){
+    throw std::invalid_argument{"shared ring capacity too large"};
+  }
+
+  std::uint32_t c=1;
+  while(c<n)c<<=1;
+  return c;
+}
+
+} /* namespace detail */
+
+template<typename T>
+class shm_publisher
+{
+  static_assert(
+    std::is_trivially_copyable_v<T>,
+    "only trivially copyable values can be published");
+
+public:
+  using value_type=T;
+
+  /* creates (or replaces) the segment, capacity is rounded up to a power
+   * of two
+   */
+
+  shm_publisher(const std::string& name,std::size_t capacity=1<<12):
+    name{name}
+  {
+    using namespace boost::interprocess;
+
+    shared_memory_object::remove(name.c_str());
+    shared_memory_object shm{create_only,name.c_str(),read_write};
+    auto                 c=detail::shm_capacity(capacity);
+    shm.truncate(detail::shm_slots_offset<T>+std::size_t(c)*sizeof(T));
+    region=mapped_region{shm,read_write};
+
+    auto p=static_cast<char*>(region.get_address());
+    hdr=new(p) detail::shm_ring_header{};
+    hdr->record_size=sizeof(T);
+    hdr->capacity=c;
+    hdr->magic.store(detail::shm_magic,std::memory_order_release);
+    slots=reinterpret_cast<T*>(p+detail::shm_slots_offset<T>);
+    mask=c-1;
+  }
+  shm_publisher(const shm_publisher&)=delete;
+  ~shm_publisher()
+  {
+    boost::interprocess::shared_memory_object::remove(name.c_str());
+  }
+
+  shm_publisher& operator=(const shm_publisher&)=delete;
+
+  bool try_publish(const T& x)
+  {
+    if(head-tail_cache>mask){
+      tail_cache=hdr->tail.load(std::memory_order_acquire);
+      if(head-tail_cache>mask)return false;
+    }
+    std::memcpy(&slots[head&mask],&x,sizeof(T));
+    hdr->head.store(++head,std::memory_order_release);
+    return true;
+  }
+
+  /* waits for the subscriber to make room */
+
+  void publish(const T& x)
+  {
+    while(!try_publish(x))std::this_thread::yield();
+  }
+
+  bool drained()const
+  {
+    return hdr->tail.load(std::memory_order_acquire)==head;
+  }
+
+private:
+  std::string                        name;
+  boost::interprocess::mapped_region region;
+  detail::shm_ring_header*           hdr;
+  T*                                 slots;
+  std::uint64_t                      mask,head=0,tail_cache=0;
+};
+
+template<typename T>
+class shm_subscriber
+{
+  static_assert(
+    std::is_trivially_copyable_v<T>,
+    "only trivially copyable values can be subscribed to");
+
+public:
+  using value_type=T;
+
+  /* a segment just created may not be initialized yet: it's waited for
+   * up to timeout before giving up
+   */
+
+  explicit shm_subscriber(
+    const std::string& name,
+    std::chrono::milliseconds timeout=std::chrono::seconds{1})
+  {
+    using namespace boost::interprocess;
+
+    auto deadline=std::chrono::steady_clock::now()+timeout;
+    for(;;){
+      shared_memory_object shm{open_only,name.c_str(),read_write};
+      offset_t             size=0;
+      if(shm.get_size(size)&&
+         std::size_t(size)>=detail::shm_slots_offset<T>){
+        region=mapped_region{shm,read_write};
+        hdr=static_cast<detail::shm_ring_header*>(region.get_address());
+        if(hdr->magic.load(std::memory_order_acquire)!=0)break;
+      }
+      if(std::chrono::steady_clock::now()>=deadline){
+        throw std::runtime_error{name+" was not initialized in time"};
+      }
+      std::this_thread::yield();
+    }
+
+    auto p=static_cast<char*>(region.get_address());
+    if(hdr->magic.load(std::memory_order_relaxed)!=detail::shm_magic||
+       hdr->record_size!=sizeof(T)){
+      throw std::runtime_error{name+" is not a shared ring for this type"};
+    }
+    auto c=hdr->capacity;
+    if(c==0||(c&(c-1))!=0||
+       region.get_size()<detail::shm_slots_offset<T>+std::size_t(c)*sizeof(T)){
+      throw std::runtime_error{name+" is a corrupt or truncated shared ring"};
+    }
+    slots=reinterpret_cast<const T*>(p+detail::shm_slots_offset<T>);
+    mask=c-1;
+    tail=head_cache=hdr->tail.load(std::memory_order_relaxed);
+  }
+
+  /* injects up to max_records pending values into trg straight from the
+   * shared slots, returns the number injected
+   */
+
+  std::size_t poll(
+    trigger<T>& trg,
+    std::size_t max_records=(std::numeric_limits<std::size_t>::max)())
+  {
+    if(tail==head_cache){
+      head_cache=hdr->head.load(std::memory_order_acquire);
+      if(tail==head_cache)return 0;
+    }
+    std::size_t m=head_cache-tail<max_records?head_cache-tail:max_records;
+    for(std::size_t i=0;i<m;++i)trg=slots[(tail+i)&mask];
+    tail+=m;
+    hdr->tail.store(tail,std::memory_order_release);
+    return m;
+  }
+
+private:
+  boost::interprocess::mapped_region region;
+  detail::shm_ring_header*           hdr;
+  const T*                           slots;
+  std::uint64_t                      mask,tail,head_cache;
+};
+
+} /* namespace usingstdcpp2019::urp */
+
+#endif
@@ -0,0 +1,294 @@
+/* Some fun with Reactive Programming in C++17.
+ *
+ * Copyright 2019 Joaquin M Lopez Munoz.
+ * Distributed under the Boost Software License, Version 1.0.
+ * (See accompanying file LICENSE_1_0.txt or copy at
+ * http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * See https://github.com/joaquintides/usingstdcpp2019 for talk material.
+ */
+
+#ifndef USINGSTDCPP2019_URP_STATIC_HPP
+#define USINGSTDCPP2019_URP_STATIC_HPP
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace usingstdcpp2019::urp{
+
+/* Graphs whose topology is fully known at compile time: nodes are named
+ * by tag types and declared in topological order,
+ *
+ *   static_graph g{
+ *     static_value<struct x>(0),
+ *     static_function<struct y,x>(f),
+ *     static_function<struct z,x,y>(g)};
+ *
+ * Values are plain tuple members, and g.set<x>(v) recomputes the
+ * descendants of x that saw a source change, in declaration order, with
+ * no signals, no type erasure and no allocation.
+ */
+
+template<typename Tag,typename T>
+struct static_value_spec
+{
+  using tag=Tag;
+
+  T init;
+};
+
+template<typename Tag,typename F,typename... SrcTags>
+struct static_function_spec
+{
+  using tag=Tag;
+
+  F f;
+};
+
+template<typename Tag,typename T>
+auto static_value(T init){return static_value_spec<Tag,T>{std::move(init)};}
+
+template<typename Tag,typename... SrcTags,typename F>
+auto static_function(F f){return static_function_spec<Tag,F,SrcTags...>{f};}
+
+namespace detail{
+
+template<typename Tag,typename... Specs>
+constexpr std::size_t static_index()
+{
+  constexpr bool found[]={std::is_same_v<Tag,typename Specs::tag>...};
+  std::size_t    i=0;
+  while(i<sizeof...(Specs)&&!found[i])++i;
+  return i;
+}
+
+/* a tag first found before its own position is a duplicate */
+
+template<typename... Specs>
+constexpr bool static_unique_tags()
+{
+  constexpr std::size_t index[]={
+    static_index<typename Specs::tag,Specs...>()...,0};
+  for(std::size_t i=0;i<sizeof...(Specs);++i)if(index[i]!=i)return false;
+  return true;
+}
+
+template<typename... Specs,typename Tag,typename T>
+constexpr bool static_sources_known(const static_value_spec<Tag,T>*)
+{
+  return true;
+}
+
+template<typename... Specs,typename Tag,typename F,typename... SrcTags>
+constexpr bool static_sources_known(
+  const static_function_spec<Tag,F,SrcTags...>*)
+{
+  return ((static_index<SrcTags,Specs...>()<sizeof...(Specs))&&...);
+}
+
+template<typename Spec,typename... Specs>
+struct static_value_type;
+
+template<typename Tag,typename T,typename... Specs>
+struct static_value_type<static_value_spec<Tag,T>,Specs...>
+{
+  using type=T;
+};
+
+template<typename Tag,typename F,typename... SrcTags,typename... Specs>
+struct static_value_type<static_function_spec<Tag,F,SrcTags...>,Specs...>
+{
+  using type=std::decay_t<std::invoke_result_t<
+    const F&,
+    const typename static_value_type<
+      std::tuple_element_t<
+        static_index<SrcTags,Specs...>(),std::tuple<Specs...>>,
+      Specs...
+    >::type&...
+  >>;
+};
+
+template<typename... Specs,typename Tag,typename T>
+constexpr auto static_reads(const static_value_spec<Tag,T>*)
+{
+  return std::array<bool,sizeof...(Specs)>{};
+}
+
+template<typename... Specs,typename Tag,typename F,typename... SrcTags>
+constexpr auto static_reads(const static_function_spec<Tag,F,SrcTags...>*)
+{
+  std::array<bool,sizeof...(Specs)> res{};
+  (
+    (static_index<SrcTags,Specs...>()<sizeof...(Specs)?
+      void(res[static_index<SrcTags,Specs...>()]=true):void()),
+    ...);
+  return res;
+}
+
+template<typename Spec>
+struct is_static_value_spec:std::false_type{};
+template<typename Tag,typename T>
+struct is_static_value_spec<static_value_spec<Tag,T>>:std::true_type{};
+
+} /* namespace detail */
+
+template<typename... Specs>
+class static_graph
+{
+  /* checked first, before anything indexes nodes by tag */
+
+  static_assert(
+    detail::static_unique_tags<Specs...>(),"duplicate node tag");
+  static_assert(
+    (detail::static_sources_known<Specs...>(
+      static_cast<const Specs*>(nullptr))&&...),
+    "unknown source");
+
+  static constexpr std::size_t N=sizeof...(Specs);
+
+  template<typename Tag>
+  static constexpr std::size_t index_of=detail::static_index<Tag,Specs...>();
+
+  template<std::size_t I>
+  using spec_type=std::tuple_element_t<I,std::tuple<Specs...>>;
+
+  template<std::size_t I>
+  using value_type_at=
+    typename detail::static_value_type<spec_type<I>,Specs...>::type;
+
+  /* reads[j][k]: node j takes node k as a source */
+
+  static constexpr std::array<std::array<bool,N>,N> reads={
+    detail::static_reads<Specs...>(static_cast<const Specs*>(nullptr))...};
+
+  static constexpr bool well_formed()
+  {
+    for(std::size_t j=0;j<N;++j){
+      for(std::size_t k=j;k<N;++k)if(reads[j][k])return false;
+    }
+    return true;
+  }
+
+  static_assert(
+    well_formed(),"source not declared before its dependents");
+
+  template<std::size_t I>
+  static constexpr std::array<bool,N> descendants_of()
+  {
+    std::array<bool,N> res{};
+    res[I]=true;
+    for(std::size_t j=I+1;j<N;++j){
+      for(std::size_t k=I;k<j;++k)if(reads[j][k]&&res[k])res[j]=true;
+    }
+    return res;
+  }
+
+  template<std::size_t I>
+  static constexpr std::array<bool,N> descendants=descendants_of<I>();
+
+public:
+  static_graph(Specs... specs):
+    specs{std::move(specs)...},values{build<0>(std::tuple<>{})}{}
+
+  template<typename Tag>
+  const auto& get()const{return std::get<index_of<Tag>>(values);}
+
+  template<typename Tag,typename T>
+  void set(T&& x)
+  {
+    constexpr std::size_t I=index_of<Tag>;
+    static_assert(I<N,"unknown node");
+    static_assert(
+      detail::is_static_value_spec<spec_type<I>>::value,
+      "only values can be set");
+
+    auto& v=std::get<I>(values);
+    if(v==x)return;
+    v=std::forward<T>(x);
+
+    std::array<bool,N> changed{};
+    changed[I]=true;
+    update<I>(changed,std::make_index_sequence<N>{});
+  }
+
+private:
+  template<std::size_t I,std::size_t... J>
+  void update(std::array<bool,N>& changed,std::index_sequence<J...>)
+  {
+    (recompute<I,J>(changed),...);
+  }
+
+  template<std::size_t I,std::size_t J>
+  void recompute(std::array<bool,N>& changed)
+  {
+    if constexpr(J>I&&descendants<I>[J]){
+      if(any_source_changed<J>(changed,std::make_index_sequence<N>{})){
+        auto u=compute<J>(values);
+        auto& v=std::get<J>(values);
+        if(!(u==v)){
+          v=std::move(u);
+          changed[J]=true;
+        }
+      }
+    }
+  }
+
+  template<std::size_t J,std::size_t... K>
+  static bool any_source_changed(
+    const std::array<bool,N>& changed,std::index_sequence<K...>)
+  {
+    return ((reads[J][K]&&changed[K])||...);
+  }
+
+  template<std::size_t J,typename Values>
+  value_type_at<J> compute(const Values& vals)const
+  {
+    return compute(std::get<J>(specs),vals);
+  }
+
+  template<typename Tag,typename T,typename Values>
+  static T compute(const static_value_spec<Tag,T>& s,const Values&)
+  {
+    return s.init;
+  }
+
+  template<typename Tag,typename F,typename... SrcTags,typename Values>
+  static auto compute(
+    const static_function_spec<Tag,F,SrcTags...>& s,const Values& vals)
+  {
+    return s.f(std::get<index_of<SrcTags>>(vals)...);
+  }
+
+  template<std::size_t J,typename Prefix>
+  auto build(Prefix prefix)const
+  {
+    if constexpr(J==N)return prefix;
+    else{
+      value_type_at<J> v=compute<J>(prefix);
+      return build<J+1>(
+        std::tuple_cat(std::move(prefix),std::tuple<value_type_at<J>>{
+          std::move(v)}));
+    }
+  }
+
+  template<std::size_t... I>
+  static auto values_type_helper(std::index_sequence<I...>)->
+    std::tuple<value_type_at<I>...>;
+
+  using values_type=
+    decltype(values_type_helper(std::make_index_sequence<N>{}));
+
+  std::tuple<Specs...> specs;
+  values_type          values;
+};
+
+} /* namespace usingstdcpp2019::urp */
+
+#endif